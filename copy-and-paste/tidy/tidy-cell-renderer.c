@@ -119,6 +119,47 @@ tidy_cell_renderer_real_get_cell_actor (TidyCellRenderer *renderer,
   return NULL;
 }
 
+/* the default implementation creates the cell actor and throws it
+ * away, for every measurement; it is only meant as a fallback, and the
+ * renderers used inside a virtualized TidyListView should override
+ * get_cell_height() with a way to compute the height of a cell without
+ * creating it, otherwise measuring the rows costs as much as creating
+ * every cell
+ */
+static ClutterUnit
+tidy_cell_renderer_real_get_cell_height (TidyCellRenderer *renderer,
+                                         TidyActor        *list_view,
+                                         const GValue     *value,
+                                         TidyCellState     state,
+                                         ClutterUnit       width,
+                                         gint              row,
+                                         gint              column)
+{
+  ClutterGeometry size = { 0, };
+  ClutterActor *cell;
+  ClutterUnit retval;
+
+  size.width = CLUTTER_UNITS_TO_DEVICE (width);
+  size.height = -1;
+
+  cell = tidy_cell_renderer_get_cell_actor (renderer, list_view,
+                                            value,
+                                            state, &size,
+                                            row, column);
+  if (!cell)
+    return 0;
+
+  g_object_ref_sink (cell);
+
+  clutter_actor_set_widthu (cell, width);
+  retval = clutter_actor_get_heightu (cell);
+
+  clutter_actor_destroy (cell);
+  g_object_unref (cell);
+
+  return retval;
+}
+
 static void
 tidy_cell_renderer_class_init (TidyCellRendererClass *klass)
 {
@@ -145,6 +186,7 @@ tidy_cell_renderer_class_init (TidyCellRendererClass *klass)
                                                         TIDY_PARAM_READWRITE));
 
   klass->get_cell_actor = tidy_cell_renderer_real_get_cell_actor;
+  klass->get_cell_height = tidy_cell_renderer_real_get_cell_height;
 }
 
 static void
@@ -181,6 +223,86 @@ tidy_cell_renderer_get_cell_actor (TidyCellRenderer *renderer,
                                 row, column);
 }
 
+/* computes the height of the cell for @value at @width; see the
+ * default implementation about the renderers that should override it
+ */
+ClutterUnit
+tidy_cell_renderer_get_cell_height (TidyCellRenderer *renderer,
+                                    TidyActor        *list_view,
+                                    const GValue     *value,
+                                    TidyCellState     state,
+                                    ClutterUnit       width,
+                                    gint              row,
+                                    gint              column)
+{
+  TidyCellRendererClass *klass;
+
+  g_return_val_if_fail (TIDY_IS_CELL_RENDERER (renderer), 0);
+  g_return_val_if_fail (TIDY_IS_ACTOR (list_view), 0);
+  g_return_val_if_fail (value != NULL, 0);
+
+  klass = TIDY_CELL_RENDERER_GET_CLASS (renderer);
+  return klass->get_cell_height (renderer, list_view,
+                                 value,
+                                 state,
+                                 width,
+                                 row, column);
+}
+
+/* rebinds a cell actor created by @renderer to a new value; returns
+ * FALSE if the renderer does not support reusing its cells, or if
+ * @cell cannot be reused for @value, in which case a new cell should
+ * be created using tidy_cell_renderer_get_cell_actor()
+ */
+gboolean
+tidy_cell_renderer_update_cell_actor (TidyCellRenderer *renderer,
+                                      TidyActor        *list_view,
+                                      ClutterActor     *cell,
+                                      const GValue     *value,
+                                      TidyCellState     state,
+                                      ClutterGeometry  *size,
+                                      gint              row,
+                                      gint              column)
+{
+  TidyCellRendererClass *klass;
+
+  g_return_val_if_fail (TIDY_IS_CELL_RENDERER (renderer), FALSE);
+  g_return_val_if_fail (TIDY_IS_ACTOR (list_view), FALSE);
+  g_return_val_if_fail (CLUTTER_IS_ACTOR (cell), FALSE);
+  g_return_val_if_fail (value != NULL, FALSE);
+
+  klass = TIDY_CELL_RENDERER_GET_CLASS (renderer);
+  if (!klass->update_cell_actor)
+    return FALSE;
+
+  return klass->update_cell_actor (renderer, list_view,
+                                   cell,
+                                   value,
+                                   state,
+                                   size,
+                                   row, column);
+}
+
+/* unbinds a cell actor that is kept around to be rebound later using
+ * tidy_cell_renderer_update_cell_actor(); the renderer should release
+ * whatever the cell holds on behalf of its current value
+ */
+void
+tidy_cell_renderer_release_cell_actor (TidyCellRenderer *renderer,
+                                       TidyActor        *list_view,
+                                       ClutterActor     *cell)
+{
+  TidyCellRendererClass *klass;
+
+  g_return_if_fail (TIDY_IS_CELL_RENDERER (renderer));
+  g_return_if_fail (TIDY_IS_ACTOR (list_view));
+  g_return_if_fail (CLUTTER_IS_ACTOR (cell));
+
+  klass = TIDY_CELL_RENDERER_GET_CLASS (renderer);
+  if (klass->release_cell_actor)
+    klass->release_cell_actor (renderer, list_view, cell);
+}
+
 void
 tidy_cell_renderer_get_alignment (TidyCellRenderer *renderer,
                                   gdouble          *x_align,
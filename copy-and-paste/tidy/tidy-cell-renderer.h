@@ -69,6 +69,24 @@ struct _TidyCellRendererClass
                                     ClutterGeometry  *size,
                                     gint              row,
                                     gint              column);
+  ClutterUnit   (* get_cell_height) (TidyCellRenderer *renderer,
+                                     TidyActor        *list_view,
+                                     const GValue     *value,
+                                     TidyCellState     state,
+                                     ClutterUnit       width,
+                                     gint              row,
+                                     gint              column);
+  gboolean      (* update_cell_actor) (TidyCellRenderer *renderer,
+                                       TidyActor        *list_view,
+                                       ClutterActor     *cell,
+                                       const GValue     *value,
+                                       TidyCellState     state,
+                                       ClutterGeometry  *size,
+                                       gint              row,
+                                       gint              column);
+  void          (* release_cell_actor) (TidyCellRenderer *renderer,
+                                        TidyActor        *list_view,
+                                        ClutterActor     *cell);
 };
 
 GType         tidy_cell_renderer_get_type       (void) G_GNUC_CONST;
@@ -79,6 +97,24 @@ ClutterActor *tidy_cell_renderer_get_cell_actor (TidyCellRenderer *renderer,
                                                  ClutterGeometry  *size,
                                                  gint              row,
                                                  gint              column);
+ClutterUnit   tidy_cell_renderer_get_cell_height (TidyCellRenderer *renderer,
+                                                  TidyActor        *list_view,
+                                                  const GValue     *value,
+                                                  TidyCellState     state,
+                                                  ClutterUnit       width,
+                                                  gint              row,
+                                                  gint              column);
+gboolean      tidy_cell_renderer_update_cell_actor (TidyCellRenderer *renderer,
+                                                    TidyActor        *list_view,
+                                                    ClutterActor     *cell,
+                                                    const GValue     *value,
+                                                    TidyCellState     state,
+                                                    ClutterGeometry  *size,
+                                                    gint              row,
+                                                    gint              column);
+void          tidy_cell_renderer_release_cell_actor (TidyCellRenderer *renderer,
+                                                     TidyActor        *list_view,
+                                                     ClutterActor     *cell);
 void          tidy_cell_renderer_get_alignment  (TidyCellRenderer *renderer,
                                                  gdouble          *x_align,
                                                  gdouble          *y_align);
@@ -45,7 +45,9 @@ enum
   PROP_SHOW_HEADERS,
   PROP_RULES_HINT,
   PROP_HADJUST,
-  PROP_VADJUST
+  PROP_VADJUST,
+  PROP_VIRTUALIZED,
+  PROP_OVERSCAN
 };
 
 enum
@@ -67,8 +69,12 @@ typedef struct _ListRow
 {
   GPtrArray *cells;
 
-  gint index;
+  /* the item displayed by the row, if any; used to find the row
+   * again when the model is sorted or filtered, see get_row_item()
+   */
+  gpointer item;
 
+  /* relative to the origin of the rows, see row_get_y() */
   ClutterUnit y_offset;
   ClutterUnit width;
   ClutterUnit height;
@@ -77,6 +83,9 @@ typedef struct _ListRow
 #define TIDY_LIST_VIEW_GET_PRIVATE(obj) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), TIDY_TYPE_LIST_VIEW, TidyListViewPrivate))
 
+/* maximum number of unused cells kept for each column */
+#define CELL_POOL_SIZE  16
+
 struct _TidyListViewPrivate
 {
   ClutterModel *model;
@@ -94,15 +103,44 @@ struct _TidyListViewPrivate
 
   ListHeader *header;
 
-  /* holds the ListRows */
-  GList *rows;
+  /* holds the ListRows, with some room in front of the first one
+   * so that prepending a row does not move the others
+   */
+  ListRow **rows;
+  guint rows_start;
+  guint rows_len;
+  guint rows_size;
+
+  /* the offsets of the rows are stored relative to this origin,
+   * which is moved up when a row is prepended instead of moving
+   * down every row; see row_get_y()
+   */
+  ClutterUnit y_origin;
+
+  /* the rows having cells when virtualized */
+  guint realized_start;
+  guint realized_end;
+
+  /* maps each ListColumn to a queue of unused cells that can be
+   * rebound to another row, see acquire_cell()
+   */
+  GHashTable *cell_pools;
 
   ClutterActorBox allocation;
 
   ClutterUnit last_row_y;
 
+  /* pending relayout, see on_row_changed() */
+  guint relayout_id;
+
+  /* space above and below the visible area for which the cells
+   * are created when virtualized, in pixels
+   */
+  guint overscan;
+
   guint show_headers : 1;
   guint rules_hint   : 1;
+  guint virtualized  : 1;
   
   TidyAdjustment *hadjustment;
   TidyAdjustment *vadjustment;
@@ -113,6 +151,7 @@ static guint view_signals[LAST_SIGNAL] = { 0, };
 static ClutterColor default_hint_color = { 0xf0, 0xb3, 0x78, 0xff };
 static guint        default_v_padding  = 2;
 static guint        default_h_padding  = 2;
+static guint        default_overscan   = 100;
 
 static void tidy_stylable_iface_init (TidyStylableIface *iface);
 
@@ -159,22 +198,300 @@ clear_header (ListHeader *header)
   g_slice_free (ListHeader, header);
 }
 
+#define rows_index(priv,i)      ((priv)->rows[(priv)->rows_start + (i)])
+
+/* makes room at both ends of the rows array */
+static void
+rows_grow (TidyListViewPrivate *priv)
+{
+  ListRow **rows;
+  guint size, start;
+
+  size = MAX (32, priv->rows_len * 3);
+  start = (size - priv->rows_len) / 2;
+
+  rows = g_new0 (ListRow *, size);
+  if (priv->rows_len > 0)
+    g_memmove (rows + start,
+               priv->rows + priv->rows_start,
+               priv->rows_len * sizeof (ListRow *));
+
+  g_free (priv->rows);
+
+  priv->rows = rows;
+  priv->rows_start = start;
+  priv->rows_size = size;
+}
+
+static void
+rows_append (TidyListViewPrivate *priv,
+             ListRow             *row)
+{
+  if (priv->rows_start + priv->rows_len == priv->rows_size)
+    rows_grow (priv);
+
+  priv->rows[priv->rows_start + priv->rows_len] = row;
+  priv->rows_len += 1;
+}
+
+/* inserts @row at @position, moving the shorter side of the array */
+static void
+rows_insert (TidyListViewPrivate *priv,
+             guint                position,
+             ListRow             *row)
+{
+  if (position < priv->rows_len / 2)
+    {
+      if (priv->rows_start == 0)
+        rows_grow (priv);
+
+      priv->rows_start -= 1;
+      g_memmove (priv->rows + priv->rows_start,
+                 priv->rows + priv->rows_start + 1,
+                 position * sizeof (ListRow *));
+    }
+  else
+    {
+      if (priv->rows_start + priv->rows_len == priv->rows_size)
+        rows_grow (priv);
+
+      g_memmove (priv->rows + priv->rows_start + position + 1,
+                 priv->rows + priv->rows_start + position,
+                 (priv->rows_len - position) * sizeof (ListRow *));
+    }
+
+  rows_index (priv, position) = row;
+  priv->rows_len += 1;
+}
+
+static ListRow *
+rows_remove (TidyListViewPrivate *priv,
+             guint                position)
+{
+  ListRow *row = rows_index (priv, position);
+
+  if (position < priv->rows_len / 2)
+    {
+      g_memmove (priv->rows + priv->rows_start + 1,
+                 priv->rows + priv->rows_start,
+                 position * sizeof (ListRow *));
+      priv->rows_start += 1;
+    }
+  else
+    g_memmove (priv->rows + priv->rows_start + position,
+               priv->rows + priv->rows_start + position + 1,
+               (priv->rows_len - position - 1) * sizeof (ListRow *));
+
+  priv->rows_len -= 1;
+
+  return row;
+}
+
+static inline ClutterUnit
+row_get_y (TidyListViewPrivate *priv,
+           ListRow             *row)
+{
+  return row->y_offset - priv->y_origin;
+}
+
+static inline void
+row_set_y (TidyListViewPrivate *priv,
+           ListRow             *row,
+           ClutterUnit          y)
+{
+  row->y_offset = y + priv->y_origin;
+}
+
+/* the offsets are fixed point values, so we bring the origin back
+ * to zero before it gets too far
+ */
+static void
+rows_rebase (TidyListViewPrivate *priv)
+{
+  guint i;
+
+  if (ABS (priv->y_origin) < CLUTTER_UNITS_FROM_DEVICE (8192))
+    return;
+
+  for (i = 0; i < priv->rows_len; i++)
+    rows_index (priv, i)->y_offset -= priv->y_origin;
+
+  priv->y_origin = 0;
+}
+
+/* returns the position of the first row ending after @y, or the
+ * number of rows if there is none
+ */
+static guint
+find_row_at_y (TidyListViewPrivate *priv,
+               ClutterUnit          y)
+{
+  guint lo = 0, hi = priv->rows_len;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+      ListRow *row = rows_index (priv, mid);
+
+      if (row_get_y (priv, row) + row->height < y)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static void
+clear_cell_pool (GQueue *pool)
+{
+  ClutterActor *cell;
+
+  while ((cell = g_queue_pop_head (pool)) != NULL)
+    {
+      clutter_actor_destroy (cell);
+      g_object_unref (cell);
+    }
+
+  g_queue_free (pool);
+}
+
 static void
-clear_row (ListRow *row)
+trim_cell_pool (gpointer key,
+                gpointer value,
+                gpointer data)
 {
+  GQueue *pool = value;
+
+  while (g_queue_get_length (pool) > CELL_POOL_SIZE)
+    {
+      ClutterActor *cell = g_queue_pop_tail (pool);
+
+      clutter_actor_destroy (cell);
+      g_object_unref (cell);
+    }
+}
+
+/* gets a cell for @column, rebinding an unused one if the renderer
+ * allows it, or creating a new one
+ */
+static ClutterActor *
+acquire_cell (TidyListView    *view,
+              TidyListColumn  *column,
+              const GValue    *value,
+              TidyCellState    state,
+              ClutterGeometry *size,
+              gint             row,
+              gint             column_id)
+{
+  TidyCellRenderer *renderer;
+  GQueue *pool;
+
+  renderer = tidy_list_column_get_cell_renderer (column);
+
+  pool = g_hash_table_lookup (view->priv->cell_pools, column);
+  while (pool && !g_queue_is_empty (pool))
+    {
+      ClutterActor *cell = g_queue_pop_head (pool);
+
+      if (tidy_cell_renderer_update_cell_actor (renderer,
+                                                TIDY_ACTOR (view),
+                                                cell,
+                                                value,
+                                                state, size,
+                                                row, column_id))
+        {
+          /* the pool owns the only reference on the cell; we make
+           * it floating again, so that it can be used like a newly
+           * created cell
+           */
+          g_object_force_floating (G_OBJECT (cell));
+
+          return cell;
+        }
+
+      clutter_actor_destroy (cell);
+      g_object_unref (cell);
+    }
+
+  return tidy_cell_renderer_get_cell_actor (renderer,
+                                            TIDY_ACTOR (view),
+                                            value,
+                                            state, size,
+                                            row, column_id);
+}
+
+/* detaches @cell from the list view, keeping it around if the
+ * renderer of @column is able to rebind it
+ */
+static void
+release_cell (TidyListView   *view,
+              TidyListColumn *column,
+              ClutterActor   *cell)
+{
+  TidyCellRenderer *renderer;
+  GQueue *pool;
+
+  renderer = tidy_list_column_get_cell_renderer (column);
+  if (!TIDY_CELL_RENDERER_GET_CLASS (renderer)->update_cell_actor)
+    {
+      clutter_actor_unparent (cell);
+      return;
+    }
+
+  pool = g_hash_table_lookup (view->priv->cell_pools, column);
+  if (!pool)
+    {
+      pool = g_queue_new ();
+      g_hash_table_insert (view->priv->cell_pools, column, pool);
+    }
+
+  g_object_ref (cell);
+  clutter_actor_unparent (cell);
+
+  tidy_cell_renderer_release_cell_actor (renderer, TIDY_ACTOR (view), cell);
+
+  g_queue_push_head (pool, cell);
+}
+
+static void
+unrealize_row (TidyListView *view,
+               ListRow      *row)
+{
+  GList *l;
   gint i;
 
-  if (G_UNLIKELY (row == NULL))
+  if (!row->cells)
     return;
 
-  if (row->cells)
+  /* the cells are only created for the visible columns */
+  for (l = view->priv->columns, i = 0;
+       l != NULL && i < row->cells->len;
+       l = l->next)
     {
-      for (i = 0; i < row->cells->len; i++)
-        clutter_actor_unparent (g_ptr_array_index (row->cells, i));
+      if (!tidy_list_column_get_visible (l->data))
+        continue;
 
-      g_ptr_array_free (row->cells, TRUE);
+      release_cell (view, l->data, g_ptr_array_index (row->cells, i));
+      i += 1;
     }
 
+  for (; i < row->cells->len; i++)
+    clutter_actor_unparent (g_ptr_array_index (row->cells, i));
+
+  g_ptr_array_free (row->cells, TRUE);
+  row->cells = NULL;
+}
+
+static void
+clear_row (TidyListView *view,
+           ListRow      *row)
+{
+  if (G_UNLIKELY (row == NULL))
+    return;
+
+  unrealize_row (view, row);
+
   g_slice_free (ListRow, row);
 }
 
@@ -183,6 +500,7 @@ clear_layout (TidyListView *view,
               gboolean      clear_headers)
 {
   TidyListViewPrivate *priv = view->priv;
+  guint i;
 
   if (clear_headers)
     {
@@ -190,14 +508,24 @@ clear_layout (TidyListView *view,
       priv->header = NULL;
     }
 
-  g_list_foreach (priv->rows, (GFunc) clear_row, NULL);
-  g_list_free (priv->rows);
-  priv->rows = NULL;
+  for (i = 0; i < priv->rows_len; i++)
+    clear_row (view, rows_index (priv, i));
+
+  priv->rows_len = 0;
+  priv->rows_start = priv->rows_size / 2;
+  priv->y_origin = 0;
+
+  priv->realized_start = priv->realized_end = 0;
 }
 
 static void
 tidy_list_view_finalize (GObject *gobject)
 {
+  TidyListViewPrivate *priv = TIDY_LIST_VIEW_GET_PRIVATE (gobject);
+
+  g_hash_table_destroy (priv->cell_pools);
+  g_free (priv->rows);
+
   G_OBJECT_CLASS (tidy_list_view_parent_class)->finalize (gobject);
 }
 
@@ -206,7 +534,14 @@ tidy_list_view_dispose (GObject *gobject)
 {
   TidyListViewPrivate *priv = TIDY_LIST_VIEW_GET_PRIVATE (gobject);
 
+  if (priv->relayout_id)
+    {
+      g_source_remove (priv->relayout_id);
+      priv->relayout_id = 0;
+    }
+
   clear_layout (TIDY_LIST_VIEW (gobject), TRUE);
+  g_hash_table_remove_all (priv->cell_pools);
 
   if (priv->model)
     {
@@ -257,6 +592,12 @@ tidy_list_view_set_property (GObject      *gobject,
                                       view->priv->hadjustment,
                                       g_value_get_object (value));
       break;
+    case PROP_VIRTUALIZED:
+      tidy_list_view_set_virtualized (view, g_value_get_boolean (value));
+      break;
+    case PROP_OVERSCAN:
+      tidy_list_view_set_overscan (view, g_value_get_uint (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -294,6 +635,12 @@ tidy_list_view_get_property (GObject    *gobject,
                                       NULL, &adjustment);
       g_value_set_object (value, adjustment);
       break;
+    case PROP_VIRTUALIZED:
+      g_value_set_boolean (value, view->priv->virtualized);
+      break;
+    case PROP_OVERSCAN:
+      g_value_set_uint (value, view->priv->overscan);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -315,51 +662,40 @@ tidy_list_view_visible_columns (TidyListView *view)
   return visible;
 }
 
-static void
-append_row_layout (TidyListView     *view,
-                   ClutterModelIter *iter)
+/* creates the cell actors of a row at the offset of the row; returns
+ * the height of the tallest cell
+ */
+static ClutterUnit
+realize_row (TidyListView     *view,
+             ListRow          *row_info,
+             guint             index_,
+             ClutterModelIter *iter)
 {
   TidyListViewPrivate *priv = view->priv;
-  ListRow *row_info;
-  guint n_columns, nv_columns;
+  guint nv_columns;
   ClutterUnit width;
-  ClutterUnit x_offset, y_offset, cell_height;
-  gint h_padding, v_padding;
+  ClutterUnit x_offset, cell_height;
+  gint h_padding;
   gint i;
   GList *l;
 
   h_padding = default_h_padding;
-  v_padding = default_v_padding;
 
-  tidy_stylable_get (TIDY_STYLABLE (view),
-                     "h-padding", &h_padding,
-                     "v-padding", &v_padding,
-                     NULL);
+  tidy_stylable_get (TIDY_STYLABLE (view), "h-padding", &h_padding, NULL);
 
   width = priv->allocation.x2 - priv->allocation.x1;
   if (width <= 0)
     width = clutter_actor_get_widthu (CLUTTER_ACTOR (view));
 
-  n_columns = g_list_length (priv->columns);
-
-  x_offset = y_offset = cell_height = 0;
+  x_offset = cell_height = 0;
 
-  y_offset = priv->last_row_y;
-  y_offset += CLUTTER_UNITS_FROM_DEVICE (v_padding);
-
-  row_info = g_slice_new (ListRow);
-  row_info->cells = g_ptr_array_sized_new (n_columns);
-  row_info->index = clutter_model_iter_get_row (iter);
-  row_info->y_offset = y_offset;
-  row_info->width = 0;
-  row_info->height = 0;
+  row_info->cells = g_ptr_array_sized_new (g_list_length (priv->columns));
 
   nv_columns = tidy_list_view_visible_columns (view);
 
   for (l = priv->columns, i = 0; l != NULL; l = l->next, i++)
     {
       TidyListColumn *column = l->data;
-      TidyCellRenderer *renderer;
       ClutterGeometry size = { 0, };
       GValue value = { 0, };
       ClutterActor *cell;
@@ -382,26 +718,26 @@ append_row_layout (TidyListView     *view,
       column_width = tidy_list_column_get_widthu (column);
       column_width = MAX ((width / nv_columns), column_width);
 
-      /* provide a geometry for the cell */
+      /* provide a geometry for the cell; ClutterGeometry is pixels
+       * based, maybe we should switch to ClutterActorBox
+       */
       size.x = CLUTTER_UNITS_TO_DEVICE (x_offset);
-      size.y = CLUTTER_UNITS_TO_DEVICE (y_offset);
+      size.y = CLUTTER_UNITS_TO_DEVICE (row_get_y (priv, row_info));
       size.width = CLUTTER_UNITS_TO_DEVICE (column_width);
       size.height = (cell_height > 0
                      ? CLUTTER_UNITS_TO_DEVICE (cell_height)
                      : -1);
 
-      renderer = tidy_list_column_get_cell_renderer (column);
-      cell = tidy_cell_renderer_get_cell_actor (renderer,
-                                                TIDY_ACTOR (view),
-                                                &value,
-                                                state, &size,
-                                                row_info->index, i);
+      cell = acquire_cell (view, column,
+                           &value,
+                           state, &size,
+                           index_, i);
 
       g_value_unset (&value);
 
       g_ptr_array_add (row_info->cells, cell);
       clutter_actor_set_parent (cell, CLUTTER_ACTOR (view));
-      clutter_actor_set_positionu (cell, x_offset, y_offset);
+      clutter_actor_set_positionu (cell, x_offset, row_get_y (priv, row_info));
       clutter_actor_set_widthu (cell, column_width);
       clutter_actor_show (cell);
 
@@ -412,65 +748,36 @@ append_row_layout (TidyListView     *view,
     }
 
   row_info->width = x_offset;
-  row_info->height = cell_height;
 
-  priv->last_row_y = y_offset;
-  priv->rows = g_list_append (priv->rows, row_info);
-
-  /* store the layout size */
-  priv->allocation.x2 = priv->allocation.x1 + width;
-  priv->allocation.y2 = priv->allocation.y1 + y_offset;
-
-  /* Adjust the adjustments */
-  if (priv->hadjustment)
-    tidy_list_view_refresh_hadjustment (view);
-
-  if (priv->vadjustment)
-    tidy_list_view_refresh_vadjustment (view);
+  return cell_height;
 }
 
-static void
-prepend_row_layout (TidyListView     *view,
-                    ClutterModelIter *iter)
+/* like realize_row(), but asks the renderers for the height of the
+ * cells instead of creating them
+ */
+static ClutterUnit
+measure_row (TidyListView     *view,
+             ListRow          *row_info,
+             guint             index_,
+             ClutterModelIter *iter)
 {
   TidyListViewPrivate *priv = view->priv;
-  ListRow *row_info;
-  guint n_columns, nv_columns;
+  guint nv_columns;
   ClutterUnit width;
-  ClutterUnit x_offset, y_offset, cell_height;
-  ClutterUnit next_row_offset;
-  gint h_padding, v_padding;
+  ClutterUnit x_offset, cell_height;
+  gint h_padding;
   gint i;
   GList *l;
 
   h_padding = default_h_padding;
-  v_padding = default_v_padding;
 
-  tidy_stylable_get (TIDY_STYLABLE (view),
-                     "h-padding", &h_padding,
-                     "v-padding", &v_padding,
-                     NULL);
+  tidy_stylable_get (TIDY_STYLABLE (view), "h-padding", &h_padding, NULL);
 
   width = priv->allocation.x2 - priv->allocation.x1;
   if (width <= 0)
     width = clutter_actor_get_widthu (CLUTTER_ACTOR (view));
 
-  n_columns = g_list_length (priv->columns);
-
-  x_offset = y_offset = cell_height = 0;
-
-  if (priv->show_headers)
-    {
-      y_offset += priv->header->height;
-      y_offset += CLUTTER_UNITS_FROM_DEVICE (v_padding);
-    }
-
-  row_info = g_slice_new (ListRow);
-  row_info->cells = g_ptr_array_sized_new (n_columns);
-  row_info->index = clutter_model_iter_get_row (iter);
-  row_info->y_offset = y_offset;
-  row_info->width = 0;
-  row_info->height = 0;
+  x_offset = cell_height = 0;
 
   nv_columns = tidy_list_view_visible_columns (view);
 
@@ -478,10 +785,8 @@ prepend_row_layout (TidyListView     *view,
     {
       TidyListColumn *column = l->data;
       TidyCellRenderer *renderer;
-      ClutterGeometry size = { 0, };
       GValue value = { 0, };
-      ClutterActor *cell;
-      ClutterUnit column_width;
+      ClutterUnit column_width, height;
       guint model_id;
       TidyCellState state;
 
@@ -500,84 +805,289 @@ prepend_row_layout (TidyListView     *view,
       column_width = tidy_list_column_get_widthu (column);
       column_width = MAX ((width / nv_columns), column_width);
 
-      /* provide a geometry for the cell */
-      size.x = CLUTTER_UNITS_TO_DEVICE (x_offset);
-      size.y = CLUTTER_UNITS_TO_DEVICE (y_offset);
-      size.width = CLUTTER_UNITS_TO_DEVICE (column_width);
-      size.height = (cell_height > 0
-                     ? CLUTTER_UNITS_TO_DEVICE (cell_height)
-                     : -1);
-
       renderer = tidy_list_column_get_cell_renderer (column);
-      cell = tidy_cell_renderer_get_cell_actor (renderer,
-                                                TIDY_ACTOR (view),
-                                                &value,
-                                                state, &size,
-                                                row_info->index, i);
+      height = tidy_cell_renderer_get_cell_height (renderer,
+                                                   TIDY_ACTOR (view),
+                                                   &value,
+                                                   state, column_width,
+                                                   index_, i);
 
       g_value_unset (&value);
 
-      g_ptr_array_add (row_info->cells, cell);
-      clutter_actor_set_parent (cell, CLUTTER_ACTOR (view));
-      clutter_actor_set_positionu (cell, x_offset, y_offset);
-      clutter_actor_set_widthu (cell, column_width);
-      clutter_actor_show (cell);
-
-      cell_height = MAX (cell_height, clutter_actor_get_heightu (cell));
-
       x_offset += column_width;
       x_offset += CLUTTER_UNITS_FROM_DEVICE (h_padding);
+
+      cell_height = MAX (cell_height, height);
     }
 
   row_info->width = x_offset;
-  row_info->height = cell_height;
 
-  next_row_offset = row_info->y_offset
-                  + cell_height
-                  + CLUTTER_UNITS_FROM_DEVICE (v_padding);
+  return cell_height;
+}
+
+/* computes the size of a row; when virtualized the cells are created
+ * later, and only if the row is visible
+ */
+static void
+layout_row (TidyListView     *view,
+            ListRow          *row_info,
+            guint             index_,
+            ClutterModelIter *iter)
+{
+  if (view->priv->virtualized)
+    row_info->height = measure_row (view, row_info, index_, iter);
+  else
+    row_info->height = realize_row (view, row_info, index_, iter);
+}
+
+/* moves the cells of a row to the current offset of the row */
+static void
+move_row_cells (TidyListView *view,
+                ListRow      *row_info)
+{
+  ClutterUnit y = row_get_y (view->priv, row_info);
+  guint i;
+
+  if (!row_info->cells)
+    return;
 
-  for (l = priv->rows; l != NULL; l = l->next)
+  for (i = 0; i < row_info->cells->len; i++)
     {
-      ListRow *r = l->data;
-      GList *c;
+      ClutterActor *cell = g_ptr_array_index (row_info->cells, i);
+      ClutterUnit x;
 
-      x_offset = 0;
+      clutter_actor_get_positionu (cell, &x, NULL);
+      clutter_actor_set_positionu (cell, x, y);
+    }
+}
 
-      r->y_offset = next_row_offset;
+/* moves the rows from @first to the last one by @delta; if fewer
+ * rows come before @first then we move the origin and the leading
+ * rows back instead
+ */
+static void
+shift_rows (TidyListView *view,
+            guint         first,
+            ClutterUnit   delta)
+{
+  TidyListViewPrivate *priv = view->priv;
+  guint i, start, end;
 
-      for (c = priv->columns, i = 0; c != NULL; c = c->next, i++)
-        {
-          TidyListColumn *column = c->data;
-          ClutterUnit column_width;
-          ClutterActor *cell;
+  if (first < priv->rows_len - first)
+    {
+      priv->y_origin -= delta;
 
-          if (!tidy_list_column_get_visible (column))
-            continue;
+      for (i = 0; i < first; i++)
+        rows_index (priv, i)->y_offset -= delta;
+    }
+  else
+    {
+      for (i = first; i < priv->rows_len; i++)
+        rows_index (priv, i)->y_offset += delta;
+    }
 
-          column_width = tidy_list_column_get_widthu (column);
-          column_width = MAX ((width / nv_columns), column_width);
+  rows_rebase (priv);
 
-          cell = g_ptr_array_index (r->cells, i);
+  if (priv->virtualized)
+    {
+      start = MAX (first, priv->realized_start);
+      end = priv->realized_end;
+    }
+  else
+    {
+      start = first;
+      end = priv->rows_len;
+    }
 
-          clutter_actor_set_positionu (cell, x_offset, next_row_offset);
+  for (i = start; i < end; i++)
+    move_row_cells (view, rows_index (priv, i));
+}
 
-          x_offset += column_width;
-          x_offset += CLUTTER_UNITS_FROM_DEVICE (h_padding);
-        }
+/* the item of a row is the object held by the first column, so
+ * that rows showing the same object can be matched
+ */
+static gpointer
+get_row_item (TidyListView     *view,
+              ClutterModelIter *iter)
+{
+  TidyListViewPrivate *priv = view->priv;
+  GValue value = { 0, };
+  gpointer retval = NULL;
+  guint model_id;
+
+  if (!priv->columns)
+    return NULL;
+
+  model_id = tidy_list_column_get_model_index (priv->columns->data);
+  clutter_model_iter_get_value (iter, model_id, &value);
+
+  /* the model holds a reference on the object */
+  if (G_VALUE_HOLDS_OBJECT (&value))
+    retval = g_value_get_object (&value);
+
+  g_value_unset (&value);
+
+  return retval;
+}
+
+/* the area of the list view that should have cells when virtualized,
+ * including the scroll offset and the overscan
+ */
+static void
+get_visible_area (TidyListView *view,
+                  ClutterUnit  *top,
+                  ClutterUnit  *bottom)
+{
+  TidyListViewPrivate *priv = view->priv;
+  ClutterActor *actor = CLUTTER_ACTOR (view);
+  ClutterUnit y, height, overscan;
+
+  y = 0;
+  height = 0;
+
+  if (clutter_actor_has_clip (actor))
+    clutter_actor_get_clipu (actor, NULL, &y, NULL, &height);
+  else if (priv->vadjustment)
+    {
+      ClutterFixed page_size;
+
+      tidy_adjustment_get_valuesx (priv->vadjustment,
+                                   NULL, NULL, NULL, NULL, NULL,
+                                   &page_size);
+      height = CLUTTER_UNITS_FROM_FIXED (page_size);
+    }
+
+  if (height <= 0)
+    height = priv->allocation.y2 - priv->allocation.y1;
+
+  if (priv->vadjustment)
+    y += CLUTTER_UNITS_FROM_FIXED (tidy_adjustment_get_valuex (priv->vadjustment));
+
+  overscan = CLUTTER_UNITS_FROM_DEVICE (priv->overscan);
+
+  *top = y - overscan;
+  *bottom = y + height + overscan;
+}
+
+/* when virtualized, creates the cells of the rows inside the visible
+ * area and destroys the cells of the rows outside of it; the rows
+ * with cells are always a contiguous range
+ */
+static void
+update_visible_rows (TidyListView *view)
+{
+  TidyListViewPrivate *priv = view->priv;
+  ClutterUnit top, bottom;
+  guint start, end, i;
+
+  if (!priv->virtualized || !priv->model)
+    return;
+
+  get_visible_area (view, &top, &bottom);
+
+  start = find_row_at_y (priv, top);
+  for (end = start; end < priv->rows_len; end++)
+    {
+      if (row_get_y (priv, rows_index (priv, end)) > bottom)
+        break;
+    }
+
+  /* release the cells of the rows that scrolled out first, so that
+   * they can be reused for the rows that scrolled in
+   */
+  for (i = priv->realized_start; i < priv->realized_end; i++)
+    {
+      if (i >= start && i < end)
+        continue;
+
+      unrealize_row (view, rows_index (priv, i));
+    }
+
+  for (i = start; i < end; i++)
+    {
+      ListRow *row_info = rows_index (priv, i);
+      ClutterModelIter *iter;
+
+      if (row_info->cells != NULL)
+        continue;
+
+      iter = clutter_model_get_iter_at_row (priv->model, i);
+      if (!iter)
+        continue;
 
-      next_row_offset = r->y_offset
-                      + r->height
-                      + CLUTTER_UNITS_FROM_DEVICE (v_padding);
+      /* the height of the row has already been measured */
+      realize_row (view, row_info, i, iter);
+
+      g_object_unref (iter);
     }
 
-  priv->last_row_y = next_row_offset;
-  priv->rows = g_list_prepend (priv->rows, row_info);
+  priv->realized_start = start;
+  priv->realized_end = end;
+
+  g_hash_table_foreach (priv->cell_pools, trim_cell_pool, NULL);
+}
+
+/* lays out a new row at @position, moving the following rows down */
+static void
+insert_row_layout (TidyListView     *view,
+                   ClutterModelIter *iter,
+                   guint             position)
+{
+  TidyListViewPrivate *priv = view->priv;
+  ListRow *row_info;
+  ClutterUnit width;
+  ClutterUnit y_offset, row_size;
+  gint v_padding;
+
+  v_padding = default_v_padding;
+
+  tidy_stylable_get (TIDY_STYLABLE (view), "v-padding", &v_padding, NULL);
+
+  width = priv->allocation.x2 - priv->allocation.x1;
+  if (width <= 0)
+    width = clutter_actor_get_widthu (CLUTTER_ACTOR (view));
+
+  if (position < priv->rows_len)
+    y_offset = row_get_y (priv, rows_index (priv, position));
+  else
+    y_offset = priv->last_row_y;
+
+  row_info = g_slice_new (ListRow);
+  row_info->cells = NULL;
+  row_info->item = get_row_item (view, iter);
+  row_info->width = 0;
+
+  /* the offset is kept by shift_rows() if the origin moves, so the
+   * cells created by layout_row() are already in place
+   */
+  row_set_y (priv, row_info, y_offset);
+
+  /* the row is only measured when virtualized; otherwise its cells
+   * are created, and the row gets the height of the actual cells
+   */
+  layout_row (view, row_info, position, iter);
+
+  row_size = row_info->height + CLUTTER_UNITS_FROM_DEVICE (v_padding);
+
+  /* when virtualized the new row has no cells yet, so it is inside
+   * the realized range only if it is between two realized rows
+   */
+  if (position <= priv->realized_start && position < priv->realized_end)
+    {
+      priv->realized_start += 1;
+      priv->realized_end += 1;
+    }
+  else if (position < priv->realized_end)
+    priv->realized_end += 1;
+
+  rows_insert (priv, position, row_info);
+  shift_rows (view, position + 1, row_size);
+
+  priv->last_row_y += row_size;
 
   /* store the layout size */
   priv->allocation.x2 = priv->allocation.x1 + width;
-  priv->allocation.y2 = priv->allocation.y2
-                      + row_info->height
-                      + CLUTTER_UNITS_FROM_DEVICE (v_padding);
+  priv->allocation.y2 = priv->allocation.y1 + priv->last_row_y;
 
   /* Adjust the adjustments */
   if (priv->hadjustment)
@@ -585,6 +1095,53 @@ prepend_row_layout (TidyListView     *view,
 
   if (priv->vadjustment)
     tidy_list_view_refresh_vadjustment (view);
+
+  update_visible_rows (view);
+}
+
+/* removes the row at @position, moving the following rows up */
+static void
+remove_row_layout (TidyListView *view,
+                   guint         position)
+{
+  TidyListViewPrivate *priv = view->priv;
+  ListRow *row_info;
+  ClutterUnit row_size;
+  gint v_padding;
+
+  v_padding = default_v_padding;
+
+  tidy_stylable_get (TIDY_STYLABLE (view), "v-padding", &v_padding, NULL);
+
+  if (position < priv->realized_start)
+    {
+      priv->realized_start -= 1;
+      priv->realized_end -= 1;
+    }
+  else if (position < priv->realized_end)
+    priv->realized_end -= 1;
+
+  row_info = rows_remove (priv, position);
+  row_size = row_info->height + CLUTTER_UNITS_FROM_DEVICE (v_padding);
+
+  /* the cells go back into the pools */
+  clear_row (view, row_info);
+
+  shift_rows (view, position, -row_size);
+
+  priv->last_row_y -= row_size;
+
+  /* store the layout size */
+  priv->allocation.y2 = priv->allocation.y1 + priv->last_row_y;
+
+  /* Adjust the adjustments */
+  if (priv->hadjustment)
+    tidy_list_view_refresh_hadjustment (view);
+
+  if (priv->vadjustment)
+    tidy_list_view_refresh_vadjustment (view);
+
+  update_visible_rows (view);
 }
 
 /* if the saved allocation is set then the layout will use that; if
@@ -603,7 +1160,7 @@ ensure_layout (TidyListView *view)
   gint row;
   gint i;
 
-  if (priv->rows)
+  if (priv->rows_len > 0)
     return;
 
   h_padding = default_h_padding;
@@ -676,130 +1233,211 @@ ensure_layout (TidyListView *view)
     
               g_ptr_array_add (header->cells, cell);
 
-              clutter_actor_set_parent (cell, actor);
-              clutter_actor_set_positionu (cell, x_offset, y_offset);
-              clutter_actor_set_widthu (cell, column_width);
-              clutter_actor_show (cell);
+              clutter_actor_set_parent (cell, actor);
+              clutter_actor_set_positionu (cell, x_offset, y_offset);
+              clutter_actor_set_widthu (cell, column_width);
+              clutter_actor_show (cell);
+
+              x_offset += column_width;
+              x_offset += CLUTTER_UNITS_FROM_DEVICE (h_padding);
+
+              header_height =
+                MAX (header_height, clutter_actor_get_heightu (cell));
+            }
+    
+          header->width = x_offset;
+          header->height = header_height;
+    
+          priv->header = header;
+    
+          y_offset += priv->header->height;
+          y_offset += v_paddingu;
+    
+          x_offset = 0;
+        }
+      else
+        {
+          y_offset += priv->header->height;
+          y_offset += v_paddingu;
+
+          x_offset = 0;
+        }
+    }
+
+  n_rows = priv->model ? clutter_model_get_n_rows (priv->model) : 0;
+
+  for (row = 0; row < n_rows; row++)
+    {
+      ListRow *row_info;
+      ClutterModelIter *iter;
+
+      iter = clutter_model_get_iter_at_row (priv->model, row);
+      if (!iter)
+        continue;
+
+      row_info = g_slice_new (ListRow);
+      row_info->cells = NULL;
+      row_info->item = get_row_item (view, iter);
+      row_info->width = 0;
+      row_info->height = 0;
+      row_set_y (priv, row_info, y_offset);
+
+      layout_row (view, row_info, priv->rows_len, iter);
+
+      g_object_unref (iter);
+
+      y_offset += row_info->height;
+      y_offset += v_paddingu;
+
+      rows_append (priv, row_info);
+    }
+
+  priv->last_row_y = y_offset;
+
+  /* store the layout size */
+  priv->allocation.x2 = priv->allocation.x1 + width;
+  priv->allocation.y2 = priv->allocation.y1 + y_offset;
+
+  /* Adjust the adjustments */
+  if (priv->hadjustment)
+    tidy_list_view_refresh_hadjustment (view);
+
+  if (priv->vadjustment)
+    tidy_list_view_refresh_vadjustment (view);
+
+  update_visible_rows (view);
+
+  /* the cells not reused by the new layout are not needed anymore */
+  g_hash_table_foreach (priv->cell_pools, trim_cell_pool, NULL);
+}
+
+static void
+clear_row_foreach (gpointer key,
+                   gpointer value,
+                   gpointer data)
+{
+  clear_row (data, value);
+}
+
+/* lays out the rows again in the order of the model after it has
+ * been sorted or filtered; the rows still showing the same item are
+ * moved, with their cells, instead of being measured and created
+ * again
+ */
+static void
+reorder_layout (TidyListView *view)
+{
+  TidyListViewPrivate *priv = view->priv;
+  GHashTable *old_rows;
+  ClutterUnit y_offset, v_paddingu;
+  gint v_padding;
+  gint row, n_rows;
+  guint i;
+
+  if (!priv->model)
+    return;
+
+  /* the headers are created by ensure_layout() */
+  if (priv->show_headers && !priv->header)
+    {
+      clear_layout (view, FALSE);
+      ensure_layout (view);
+      return;
+    }
 
-              x_offset += column_width;
-              x_offset += CLUTTER_UNITS_FROM_DEVICE (h_padding);
+  v_padding = default_v_padding;
 
-              header_height =
-                MAX (header_height, clutter_actor_get_heightu (cell));
-            }
-    
-          header->width = x_offset;
-          header->height = header_height;
-    
-          priv->header = header;
-    
-          y_offset += priv->header->height;
-          y_offset += v_paddingu;
-    
-          x_offset = 0;
-        }
+  tidy_stylable_get (TIDY_STYLABLE (view), "v-padding", &v_padding, NULL);
+
+  v_paddingu = CLUTTER_UNITS_FROM_DEVICE (v_padding);
+
+  /* the rows that will be visible after the reordering are
+   * probably different; rebinding their cells is cheap
+   */
+  if (priv->virtualized)
+    {
+      for (i = priv->realized_start; i < priv->realized_end; i++)
+        unrealize_row (view, rows_index (priv, i));
+    }
+
+  old_rows = g_hash_table_new (NULL, NULL);
+
+  for (i = 0; i < priv->rows_len; i++)
+    {
+      ListRow *row_info = rows_index (priv, i);
+
+      if (row_info->item == NULL ||
+          g_hash_table_lookup (old_rows, row_info->item) != NULL)
+        clear_row (view, row_info);
       else
-        {
-          y_offset += priv->header->height;
-          y_offset += v_paddingu;
+        g_hash_table_insert (old_rows, row_info->item, row_info);
+    }
 
-          x_offset = 0;
-        }
+  priv->rows_len = 0;
+  priv->rows_start = priv->rows_size / 2;
+  priv->y_origin = 0;
+
+  priv->realized_start = priv->realized_end = 0;
+
+  y_offset = 0;
+
+  if (priv->show_headers)
+    {
+      y_offset += priv->header->height;
+      y_offset += v_paddingu;
     }
 
-  n_rows = priv->model ? clutter_model_get_n_rows (priv->model) : 0;
+  n_rows = clutter_model_get_n_rows (priv->model);
 
   for (row = 0; row < n_rows; row++)
     {
       ListRow *row_info;
       ClutterModelIter *iter;
-      ClutterUnit cell_height = 0;
+      gpointer item;
 
       iter = clutter_model_get_iter_at_row (priv->model, row);
       if (!iter)
         continue;
 
-      row_info = g_slice_new (ListRow);
-      row_info->cells = g_ptr_array_sized_new (n_columns);
-      row_info->index = row;
-      row_info->y_offset = y_offset;
-      row_info->width = 0;
-      row_info->height = 0;
+      item = get_row_item (view, iter);
 
-      for (l = priv->columns, i = 0; l != NULL; l = l->next, i++)
+      row_info = item ? g_hash_table_lookup (old_rows, item) : NULL;
+      if (row_info)
         {
-          TidyListColumn *column = l->data;
-          TidyCellRenderer *renderer;
-          ClutterGeometry size = { 0, };
-          GValue value = { 0, };
-          ClutterActor *cell;
-          ClutterUnit column_width;
-          guint model_id;
-          TidyCellState state;
-
-          if (!tidy_list_column_get_visible (column))
-            continue;
-
-          model_id = tidy_list_column_get_model_index (column);
-
-          if (model_id == clutter_model_get_sorting_column (priv->model))
-            state = TIDY_CELL_SORTING;
-          else
-            state = TIDY_CELL_NORMAL;
-
-          clutter_model_iter_get_value (iter, model_id, &value);
-
-          column_width = tidy_list_column_get_widthu (column);
-          column_width = MAX ((width / nv_columns), column_width);
-
-          /* see above, re: ClutterGeometry */
-          size.x = CLUTTER_UNITS_TO_DEVICE (x_offset);
-          size.y = CLUTTER_UNITS_TO_DEVICE (y_offset);
-          size.width = CLUTTER_UNITS_TO_DEVICE (column_width);
-          size.height = (cell_height > 0
-                         ? CLUTTER_UNITS_TO_DEVICE (cell_height)
-                         : -1);
-
-          renderer = tidy_list_column_get_cell_renderer (column);
-          cell = tidy_cell_renderer_get_cell_actor (renderer,
-                                                    TIDY_ACTOR (actor),
-                                                    &value,
-                                                    state, &size,
-                                                    row, i);
+          g_hash_table_remove (old_rows, item);
 
-          g_value_unset (&value);
+          row_set_y (priv, row_info, y_offset);
+          rows_append (priv, row_info);
 
-          g_ptr_array_add (row_info->cells, cell);
-          clutter_actor_set_parent (cell, actor);
-          clutter_actor_set_positionu (cell, x_offset, y_offset);
-          clutter_actor_set_widthu (cell, column_width);
-          clutter_actor_show (cell);
+          move_row_cells (view, row_info);
+        }
+      else
+        {
+          row_info = g_slice_new (ListRow);
+          row_info->cells = NULL;
+          row_info->item = item;
+          row_info->width = 0;
+          row_info->height = 0;
+          row_set_y (priv, row_info, y_offset);
 
-          x_offset += column_width;
-          x_offset += CLUTTER_UNITS_FROM_DEVICE (h_padding);
+          layout_row (view, row_info, priv->rows_len, iter);
 
-          cell_height = MAX (cell_height, clutter_actor_get_heightu (cell));
+          rows_append (priv, row_info);
         }
 
-      row_info->width = x_offset;
-      row_info->height = cell_height;
-
       g_object_unref (iter);
 
-      y_offset += cell_height;
+      y_offset += row_info->height;
       y_offset += v_paddingu;
-
-      x_offset = 0;
-
-      priv->rows = g_list_prepend (priv->rows, row_info);
     }
 
-  priv->last_row_y = y_offset;
+  /* the rows that are not in the model anymore */
+  g_hash_table_foreach (old_rows, clear_row_foreach, view);
+  g_hash_table_destroy (old_rows);
 
-  priv->rows = g_list_reverse (priv->rows);
+  priv->last_row_y = y_offset;
 
   /* store the layout size */
-  priv->allocation.x2 = priv->allocation.x1 + width;
   priv->allocation.y2 = priv->allocation.y1 + y_offset;
 
   /* Adjust the adjustments */
@@ -808,6 +1446,10 @@ ensure_layout (TidyListView *view)
 
   if (priv->vadjustment)
     tidy_list_view_refresh_vadjustment (view);
+
+  update_visible_rows (view);
+
+  g_hash_table_foreach (priv->cell_pools, trim_cell_pool, NULL);
 }
 
 static void
@@ -815,57 +1457,24 @@ on_row_added (ClutterModel     *model,
               ClutterModelIter *iter,
               TidyListView     *list_view)
 {
-  ClutterModelIter *copy = NULL;
-  guint row;
+  TidyListViewPrivate *priv = list_view->priv;
+  gint row;
 
-  /* the row is guaranteed to already be inside the model; we need to
-   * check if it's the last one as well. XXX this is a hack based on
-   * the fact that we know how the implementation of the model works.
-   *
-   * we need a ClutterModelIter::copy() function so we can copy the
-   * passed iterator, advance the copy and check if it's the last
-   * row.
-   */
   row = clutter_model_iter_get_row (iter);
-  copy = clutter_model_get_iter_at_row (model, row);
 
-  /* if the row was appended, then there's no need to rebuild the
-   * entire layout of the list view
-   */
-  if (copy)
+  if (row >= 0)
     {
-      if (clutter_model_iter_is_last (copy))
-        {
-          append_row_layout (list_view, iter);
-          goto done;
-        }
+      /* some models report the number of rows as the position
+       * of an appended row
+       */
+      insert_row_layout (list_view, iter, MIN (row, priv->rows_len));
     }
-
-  if (copy)
+  else
     {
-      if (clutter_model_iter_is_first (copy))
-        {
-          prepend_row_layout (list_view, iter);
-          goto done;
-        }
-      else
-        {
-          copy = clutter_model_iter_prev (copy);
-          if (clutter_model_iter_is_first (copy))
-            {
-              prepend_row_layout (list_view, iter);
-              goto done;
-            }
-        }
+      clear_layout (list_view, FALSE);
+      ensure_layout (list_view);
     }
 
-  clear_layout (list_view, FALSE);
-  ensure_layout (list_view);
-
-done:
-  if (copy)
-    g_object_unref (copy);
-
   if (CLUTTER_ACTOR_IS_VISIBLE (list_view))
     clutter_actor_queue_redraw (CLUTTER_ACTOR (list_view));
 }
@@ -875,8 +1484,53 @@ on_row_removed (ClutterModel     *model,
                 ClutterModelIter *iter,
                 TidyListView     *list_view)
 {
-  clear_layout (list_view, FALSE);
-  ensure_layout (list_view);
+  TidyListViewPrivate *priv = list_view->priv;
+  gint row;
+
+  row = clutter_model_iter_get_row (iter);
+
+  if (row >= 0 && row < priv->rows_len)
+    remove_row_layout (list_view, row);
+  else
+    {
+      clear_layout (list_view, FALSE);
+      ensure_layout (list_view);
+    }
+
+  if (CLUTTER_ACTOR_IS_VISIBLE (list_view))
+    clutter_actor_queue_redraw (CLUTTER_ACTOR (list_view));
+}
+
+static gboolean
+relayout_idle (gpointer data)
+{
+  TidyListView *view = data;
+
+  view->priv->relayout_id = 0;
+
+  clear_layout (view, FALSE);
+  ensure_layout (view);
+
+  if (CLUTTER_ACTOR_IS_VISIBLE (view))
+    clutter_actor_queue_redraw (CLUTTER_ACTOR (view));
+
+  return FALSE;
+}
+
+/* models might change many rows in a row, e.g. when the contents
+ * of the rows are loaded asynchronously; we relayout only once
+ * for all the changes, before the next redraw
+ */
+static void
+queue_relayout (TidyListView *view)
+{
+  if (view->priv->relayout_id)
+    return;
+
+  view->priv->relayout_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                             relayout_idle,
+                                             view,
+                                             NULL);
 }
 
 static void
@@ -902,7 +1556,22 @@ on_row_changed (ClutterModel     *model,
    */
 
   row = clutter_model_iter_get_row (iter);
-  row_info = g_list_nth_data (priv->rows, row);
+  row_info = (row >= 0 && row < priv->rows_len) ? rows_index (priv, row)
+                                                  : NULL;
+
+  if (row_info)
+    row_info->item = get_row_item (view, iter);
+
+  /* rows without cells are outside of the visible area, so we only
+   * need to check whether their size changed
+   */
+  if (row_info && row_info->cells == NULL)
+    {
+      if (measure_row (view, row_info, row, iter) != row_info->height)
+        queue_relayout (view);
+
+      return;
+    }
 
   if (row_info)
     {
@@ -933,9 +1602,7 @@ on_row_changed (ClutterModel     *model,
           if (row_info->cells->len <= i)
             break;
 
-          /* Replace cell */
           old_cell = (ClutterActor *) g_ptr_array_index (row_info->cells, i);
-          clutter_actor_hide (old_cell);
 
           model_id = tidy_list_column_get_model_index (column);
 
@@ -954,17 +1621,35 @@ on_row_changed (ClutterModel     *model,
                          ? CLUTTER_UNITS_TO_DEVICE (cell_height)
                          : -1);
 
+          /* rebind the cell if possible, otherwise replace it */
           renderer = tidy_list_column_get_cell_renderer (column);
-          cell = tidy_cell_renderer_get_cell_actor (renderer,
+          if (tidy_cell_renderer_update_cell_actor (renderer,
                                                     TIDY_ACTOR (actor),
+                                                    old_cell,
                                                     &value,
                                                     state, &size,
-                                                    row, i);
+                                                    row, i))
+            cell = old_cell;
+          else
+            {
+              clutter_actor_hide (old_cell);
+
+              cell = tidy_cell_renderer_get_cell_actor (renderer,
+                                                        TIDY_ACTOR (actor),
+                                                        &value,
+                                                        state, &size,
+                                                        row, i);
+
+              g_ptr_array_index (row_info->cells, i) = cell;
+              clutter_actor_set_parent (cell, actor);
+
+              /* Remove old cell */
+              clutter_actor_unparent (old_cell);
+            }
+
           g_value_unset (&value);
 
-          g_ptr_array_index (row_info->cells, i) = cell;
-          clutter_actor_set_parent (cell, actor);
-          clutter_actor_set_positionu (cell, x_offset, row_info->y_offset);
+          clutter_actor_set_positionu (cell, x_offset, row_get_y (priv, row_info));
           clutter_actor_set_widthu (cell, column_width);
           clutter_actor_show (cell);
 
@@ -972,9 +1657,6 @@ on_row_changed (ClutterModel     *model,
 
           x_offset += column_width;
           x_offset += CLUTTER_UNITS_FROM_DEVICE (h_padding);
-
-          /* Remove old cell */
-          clutter_actor_unparent (old_cell);
         }
 
       /* If row height is unchanged, new cells fit within the old cell space */
@@ -988,24 +1670,27 @@ on_row_changed (ClutterModel     *model,
     }
 
   /* Relayout */
-  clear_layout (view, FALSE);
-  ensure_layout (view);
+  queue_relayout (view);
 }
 
 static void
 on_sort_changed (ClutterModel *model,
                  TidyListView *list_view)
 {
-  clear_layout (list_view, FALSE);
-  ensure_layout (list_view);
+  reorder_layout (list_view);
+
+  if (CLUTTER_ACTOR_IS_VISIBLE (list_view))
+    clutter_actor_queue_redraw (CLUTTER_ACTOR (list_view));
 }
 
 static void
 on_filter_changed (ClutterModel *model,
                    TidyListView *list_view)
 {
-  clear_layout (list_view, FALSE);
-  ensure_layout (list_view);
+  reorder_layout (list_view);
+
+  if (CLUTTER_ACTOR_IS_VISIBLE (list_view))
+    clutter_actor_queue_redraw (CLUTTER_ACTOR (list_view));
 }
 
 static void
@@ -1038,7 +1723,7 @@ tidy_list_view_paint_or_pick (ClutterActor *actor,
 {
   TidyListViewPrivate *priv;
   ClutterColor *hint_color = NULL;
-  GList *l;
+  guint r, first_row;
   ClutterUnit i, x, y, width, height;
   guint h_padding, v_padding;
   ClutterUnit h_paddingu, v_paddingu;
@@ -1089,27 +1774,26 @@ tidy_list_view_paint_or_pick (ClutterActor *actor,
       y += CLUTTER_UNITS_FROM_FIXED (voffset);
     }
 
+  /* skip the rows before the clip region */
+  first_row = has_clip ? find_row_at_y (priv, y - v_paddingu) : 0;
+
   /* rows painted first first */
-  for (l = priv->rows; l != NULL; l = l->next)
+  for (r = first_row; r < priv->rows_len; r++)
     {
-      ListRow *row = l->data;
+      ListRow *row = rows_index (priv, r);
       gint i;
-      ClutterUnit row_offset = row->y_offset;
+      ClutterUnit row_offset = row_get_y (priv, row);
       ClutterUnit row_width = row->width;
       ClutterUnit row_height = row->height;
 
       /* TODO: Skip columns that aren't visible */
 
-      /* skip rows before the clip region */
-      if (has_clip && ((row_offset + row_height + v_paddingu) < y))
-        continue;
-
       /* skip rows after the clip region */
       if (has_clip && ((row_offset - v_paddingu / 2) > y + height))
         break;
 
       /* hinting */
-      if (!pick && G_LIKELY (priv->rules_hint) && (row->index % 2))
+      if (!pick && G_LIKELY (priv->rules_hint) && (r % 2))
         {
           cogl_enable (CGL_ENABLE_BLEND);
           cogl_color (hint_color);
@@ -1119,6 +1803,10 @@ tidy_list_view_paint_or_pick (ClutterActor *actor,
                           CLUTTER_UNITS_TO_DEVICE (row_height + (v_paddingu / 2)));
         }
 
+      /* rows outside of the visible area do not have cells */
+      if (!row->cells)
+        continue;
+
       for (i = 0; i < row->cells->len; i++)
         {
           ClutterActor *cell = g_ptr_array_index (row->cells, i);
@@ -1229,7 +1917,7 @@ tidy_list_view_key_press (ClutterActor    *actor,
   guint h_padding, v_padding;
   ClutterUnit h_paddingu, v_paddingu;
   gboolean has_clip;
-  GList *l;
+  guint r;
 
   if (!priv->vadjustment)
     return FALSE;
@@ -1265,17 +1953,14 @@ tidy_list_view_key_press (ClutterActor    *actor,
 
   y += CLUTTER_UNITS_FROM_FIXED (value);
 
-  /* rows painted first first */
-  for (l = priv->rows; l != NULL; l = l->next)
+  /* rows painted first first, skipping the leading rows */
+  r = has_clip ? find_row_at_y (priv, y - v_paddingu) : 0;
+  for (; r < priv->rows_len; r++)
     {
-      ListRow *row = l->data;
-      ClutterUnit row_offset = row->y_offset;
+      ListRow *row = rows_index (priv, r);
+      ClutterUnit row_offset = row_get_y (priv, row);
       ClutterUnit row_height = row->height;
 
-      /* leading rows */
-      if (has_clip && ((row_offset + row_height + v_paddingu) < y))
-        continue;
-
       /* trailing rows */
       if (has_clip && ((row_offset - v_paddingu / 2) > y + height))
         break;;
@@ -1401,6 +2086,22 @@ tidy_list_view_class_init (TidyListViewClass *klass)
                                                          TRUE,
                                                          TIDY_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class,
+                                   PROP_VIRTUALIZED,
+                                   g_param_spec_boolean ("virtualized",
+                                                         "Virtualized",
+                                                         "Whether the cells should be created only for the visible rows",
+                                                         FALSE,
+                                                         TIDY_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class,
+                                   PROP_OVERSCAN,
+                                   g_param_spec_uint ("overscan",
+                                                      "Overscan",
+                                                      "Space around the visible area with cells when virtualized, in px",
+                                                      0, G_MAXUINT,
+                                                      100,
+                                                      TIDY_PARAM_READWRITE));
+
   g_object_class_override_property (gobject_class,
                                     PROP_HADJUST,
                                     "hadjustment");
@@ -1466,6 +2167,8 @@ vadjustment_value_notify_cb (TidyAdjustment *adjustment,
                              GParamSpec     *pspec,
                              gpointer        user_data)
 {
+  update_visible_rows (TIDY_LIST_VIEW (user_data));
+
   clutter_actor_queue_redraw (CLUTTER_ACTOR (user_data));
 }
 
@@ -1636,6 +2339,8 @@ tidy_list_view_notify_clip_cb (GObject *gobject,
 
   if (view->priv->vadjustment)
     tidy_list_view_refresh_vadjustment (view);
+
+  update_visible_rows (view);
 }
 
 static void
@@ -1647,6 +2352,12 @@ tidy_list_view_init (TidyListView *view)
 
   priv->show_headers = TRUE;
   priv->rules_hint = TRUE;
+  priv->virtualized = FALSE;
+  priv->overscan = default_overscan;
+
+  priv->cell_pools = g_hash_table_new_full (NULL, NULL,
+                                            NULL,
+                                            (GDestroyNotify) clear_cell_pool);
   
   g_signal_connect (view, "notify::clip",
                     G_CALLBACK (tidy_list_view_notify_clip_cb),
@@ -1680,7 +2391,14 @@ tidy_list_view_set_model (TidyListView *view,
       g_signal_handler_disconnect (priv->model, priv->sort_changed_id);
       g_signal_handler_disconnect (priv->model, priv->filter_changed_id);
 
+      if (priv->relayout_id)
+        {
+          g_source_remove (priv->relayout_id);
+          priv->relayout_id = 0;
+        }
+
       clear_layout (view, TRUE);
+      g_hash_table_remove_all (priv->cell_pools);
 
       g_list_foreach (priv->columns, (GFunc) g_object_unref, NULL);
       g_list_free (priv->columns);
@@ -1858,6 +2576,69 @@ tidy_list_view_get_rules_hint (TidyListView *view)
   return view->priv->rules_hint;
 }
 
+void
+tidy_list_view_set_virtualized (TidyListView *view,
+                                gboolean      virtualized)
+{
+  TidyListViewPrivate *priv;
+
+  g_return_if_fail (TIDY_IS_LIST_VIEW (view));
+
+  priv = view->priv;
+
+  if (priv->virtualized != virtualized)
+    {
+      priv->virtualized = virtualized;
+
+      clear_layout (view, FALSE);
+      ensure_layout (view);
+
+      g_object_notify (G_OBJECT (view), "virtualized");
+
+      if (CLUTTER_ACTOR_IS_VISIBLE (view))
+        clutter_actor_queue_redraw (CLUTTER_ACTOR (view));
+    }
+}
+
+gboolean
+tidy_list_view_get_virtualized (TidyListView *view)
+{
+  g_return_val_if_fail (TIDY_IS_LIST_VIEW (view), FALSE);
+
+  return view->priv->virtualized;
+}
+
+void
+tidy_list_view_set_overscan (TidyListView *view,
+                             guint         overscan)
+{
+  TidyListViewPrivate *priv;
+
+  g_return_if_fail (TIDY_IS_LIST_VIEW (view));
+
+  priv = view->priv;
+
+  if (priv->overscan != overscan)
+    {
+      priv->overscan = overscan;
+
+      update_visible_rows (view);
+
+      g_object_notify (G_OBJECT (view), "overscan");
+
+      if (CLUTTER_ACTOR_IS_VISIBLE (view))
+        clutter_actor_queue_redraw (CLUTTER_ACTOR (view));
+    }
+}
+
+guint
+tidy_list_view_get_overscan (TidyListView *view)
+{
+  g_return_val_if_fail (TIDY_IS_LIST_VIEW (view), 0);
+
+  return view->priv->overscan;
+}
+
 gint
 tidy_list_view_get_row_at_pos (TidyListView *view,
                                gint          x_coord,
@@ -1865,8 +2646,8 @@ tidy_list_view_get_row_at_pos (TidyListView *view,
 {
   TidyListViewPrivate *priv;
   ClutterUnit real_x, real_y;
-  GList *r;
-  int i;
+  ListRow *row;
+  guint i;
 
   g_return_val_if_fail (TIDY_IS_LIST_VIEW (view), -1);
 
@@ -1875,7 +2656,7 @@ tidy_list_view_get_row_at_pos (TidyListView *view,
   if (!priv->model)
     return -1;
 
-  if (!priv->rows)
+  if (priv->rows_len == 0)
     return -1;
 
   if (!clutter_actor_transform_stage_point (CLUTTER_ACTOR (view),
@@ -1892,19 +2673,16 @@ tidy_list_view_get_row_at_pos (TidyListView *view,
     real_y +=
       CLUTTER_UNITS_FROM_FIXED (tidy_adjustment_get_valuex (priv->vadjustment));
   
-  /* If there was a sorted array of ListRow that echoed the priv->rows
-   * linked list, then we could do a much faster binary search on it.
-   * This implementation should be ok for a small number of rows however
-   */
-  for (r = priv->rows, i = 0; r; r = r->next, i++)
-    {
-      ListRow *row = r->data;
+  /* the rows are sorted by offset, so we can bisect them */
+  i = find_row_at_y (priv, real_y);
+  if (i >= priv->rows_len)
+    return -1;
 
-      if (real_y >= row->y_offset && real_y <= row->y_offset + row->height)
-	return i;
-    }
+  row = rows_index (priv, i);
+  if (real_y < row_get_y (priv, row))
+    return -1;
 
-  return -1;
+  return i;
 }
 
 void
@@ -1930,15 +2708,13 @@ tidy_list_view_get_cell_geometry (TidyListView    *view,
   if (!priv->model)
     return;
 
-  if (!priv->rows)
+  if (row_index >= priv->rows_len)
     return;
 
-  row = g_list_nth_data (priv->rows, row_index);
-  if (!row)
-    return;
+  row = rows_index (priv, row_index);
 
   x = 0;
-  y = row->y_offset;
+  y = row_get_y (priv, row);
   width = 0;
   height = row->height;
 
@@ -82,6 +82,12 @@ gboolean        tidy_list_view_get_show_headers  (TidyListView    *view);
 void            tidy_list_view_set_rules_hint    (TidyListView    *view,
                                                   gboolean         rules_hint);
 gboolean        tidy_list_view_get_rules_hint    (TidyListView    *view);
+void            tidy_list_view_set_virtualized   (TidyListView    *view,
+                                                  gboolean         virtualized);
+gboolean        tidy_list_view_get_virtualized   (TidyListView    *view);
+void            tidy_list_view_set_overscan      (TidyListView    *view,
+                                                  guint            overscan);
+guint           tidy_list_view_get_overscan      (TidyListView    *view);
 
 gint            tidy_list_view_get_row_at_pos    (TidyListView    *view,
                                                   gint             x_coord,
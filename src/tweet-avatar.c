@@ -0,0 +1,185 @@
+/* tweet-avatar.c: Shared textures for the profile images
+ *
+ * This file is part of Tweet.
+ * Copyright (C) 2008  Emmanuele Bassi  <ebassi@gnome.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <glib.h>
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <clutter/clutter.h>
+
+#include "tweet-avatar.h"
+#include "tweet-utils.h"
+
+/* every profile image is scaled down to the size of the avatars
+ * and uploaded only once; the avatars are clones of that texture,
+ * which is released when the last avatar using it goes away
+ */
+typedef struct
+{
+  gchar *url;
+
+  ClutterActor *texture;
+
+  guint n_avatars;
+} AvatarImage;
+
+static GHashTable *avatar_images = NULL;
+
+static GQuark quark_avatar_image = 0;
+
+static void
+avatar_image_free (gpointer data)
+{
+  AvatarImage *image = data;
+
+  clutter_actor_destroy (image->texture);
+  g_object_unref (image->texture);
+
+  g_free (image->url);
+
+  g_slice_free (AvatarImage, image);
+}
+
+static AvatarImage *
+avatar_image_get (const gchar *url,
+                  GdkPixbuf   *pixbuf)
+{
+  AvatarImage *image;
+  GdkPixbuf *thumbnail;
+
+  if (G_UNLIKELY (avatar_images == NULL))
+    {
+      avatar_images = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                             NULL,
+                                             avatar_image_free);
+      quark_avatar_image = g_quark_from_static_string ("tweet-avatar-image");
+    }
+
+  image = g_hash_table_lookup (avatar_images, url);
+  if (image)
+    return image;
+
+  if (gdk_pixbuf_get_width (pixbuf) != TWEET_AVATAR_SIZE ||
+      gdk_pixbuf_get_height (pixbuf) != TWEET_AVATAR_SIZE)
+    thumbnail = gdk_pixbuf_scale_simple (pixbuf,
+                                         TWEET_AVATAR_SIZE,
+                                         TWEET_AVATAR_SIZE,
+                                         GDK_INTERP_BILINEAR);
+  else
+    thumbnail = g_object_ref (pixbuf);
+
+  image = g_slice_new (AvatarImage);
+  image->url = g_strdup (url);
+  image->n_avatars = 0;
+
+  image->texture = tweet_texture_new_from_pixbuf (thumbnail);
+  g_object_ref_sink (image->texture);
+
+  /* the clones paint the texture of their parent */
+  clutter_actor_realize (image->texture);
+
+  g_object_unref (thumbnail);
+
+  g_hash_table_insert (avatar_images, image->url, image);
+
+  return image;
+}
+
+static void
+avatar_image_release (gpointer  data,
+                      GObject  *where_the_avatar_was)
+{
+  AvatarImage *image = data;
+
+  image->n_avatars -= 1;
+  if (image->n_avatars == 0)
+    g_hash_table_remove (avatar_images, image->url);
+}
+
+static void
+avatar_set_image (ClutterActor *avatar,
+                  AvatarImage  *image)
+{
+  AvatarImage *old_image;
+
+  old_image = g_object_get_qdata (G_OBJECT (avatar), quark_avatar_image);
+  if (old_image == image)
+    return;
+
+  image->n_avatars += 1;
+  g_object_weak_ref (G_OBJECT (avatar), avatar_image_release, image);
+  g_object_set_qdata (G_OBJECT (avatar), quark_avatar_image, image);
+
+  clutter_clone_texture_set_parent_texture (CLUTTER_CLONE_TEXTURE (avatar),
+                                            CLUTTER_TEXTURE (image->texture));
+
+  /* the old texture might go away, so it is released last */
+  if (old_image)
+    {
+      g_object_weak_unref (G_OBJECT (avatar), avatar_image_release, old_image);
+      avatar_image_release (old_image, G_OBJECT (avatar));
+    }
+}
+
+/* returns a new actor showing the profile image at @url, using
+ * @pixbuf if the image has not been uploaded yet
+ */
+ClutterActor *
+tweet_avatar_new (const gchar *url,
+                  GdkPixbuf   *pixbuf)
+{
+  ClutterActor *retval;
+  AvatarImage *image;
+
+  g_return_val_if_fail (url != NULL, NULL);
+  g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
+
+  image = avatar_image_get (url, pixbuf);
+
+  retval = clutter_clone_texture_new (CLUTTER_TEXTURE (image->texture));
+  avatar_set_image (retval, image);
+
+  clutter_actor_set_size (retval, TWEET_AVATAR_SIZE, TWEET_AVATAR_SIZE);
+
+  return retval;
+}
+
+/* makes @avatar show the profile image at @url */
+void
+tweet_avatar_set_image (ClutterActor *avatar,
+                        const gchar  *url,
+                        GdkPixbuf    *pixbuf)
+{
+  g_return_if_fail (tweet_is_avatar (avatar));
+  g_return_if_fail (url != NULL);
+  g_return_if_fail (GDK_IS_PIXBUF (pixbuf));
+
+  avatar_set_image (avatar, avatar_image_get (url, pixbuf));
+}
+
+gboolean
+tweet_is_avatar (ClutterActor *actor)
+{
+  if (!CLUTTER_IS_CLONE_TEXTURE (actor) || quark_avatar_image == 0)
+    return FALSE;
+
+  return g_object_get_qdata (G_OBJECT (actor), quark_avatar_image) != NULL;
+}
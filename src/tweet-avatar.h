@@ -0,0 +1,38 @@
+/* tweet-avatar.h: Shared textures for the profile images
+ *
+ * This file is part of Tweet.
+ * Copyright (C) 2008  Emmanuele Bassi  <ebassi@gnome.org>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __TWEET_AVATAR_H__
+#define __TWEET_AVATAR_H__
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <clutter/clutter-actor.h>
+
+G_BEGIN_DECLS
+
+#define TWEET_AVATAR_SIZE       48
+
+ClutterActor *tweet_avatar_new       (const gchar  *url,
+                                      GdkPixbuf    *pixbuf);
+void          tweet_avatar_set_image (ClutterActor *avatar,
+                                      const gchar  *url,
+                                      GdkPixbuf    *pixbuf);
+gboolean      tweet_is_avatar        (ClutterActor *actor);
+
+G_END_DECLS
+
+#endif /* __TWEET_AVATAR_H__ */
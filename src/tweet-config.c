@@ -41,6 +41,9 @@ struct _TweetConfigPrivate
 
   guint refresh_time;
 
+  gint max_statuses;
+  gint max_status_age;
+
   guint use_gtk_bg : 1;
 };
 
@@ -51,7 +54,9 @@ enum
   PROP_USERNAME,
   PROP_PASSWORD,
   PROP_REFRESH_TIME,
-  PROP_USE_GTK_BG
+  PROP_USE_GTK_BG,
+  PROP_MAX_STATUSES,
+  PROP_MAX_STATUS_AGE
 };
 
 enum
@@ -104,6 +109,14 @@ tweet_config_set_property (GObject      *gobject,
       tweet_config_set_use_gtk_bg (config, g_value_get_boolean (value));
       break;
 
+    case PROP_MAX_STATUSES:
+      tweet_config_set_max_statuses (config, g_value_get_int (value));
+      break;
+
+    case PROP_MAX_STATUS_AGE:
+      tweet_config_set_max_status_age (config, g_value_get_int (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -136,6 +149,14 @@ tweet_config_get_property (GObject    *gobject,
       g_value_set_boolean (value, priv->use_gtk_bg);
       break;
 
+    case PROP_MAX_STATUSES:
+      g_value_set_int (value, priv->max_statuses);
+      break;
+
+    case PROP_MAX_STATUS_AGE:
+      g_value_set_int (value, priv->max_status_age);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -182,6 +203,22 @@ tweet_config_class_init (TweetConfigClass *klass)
                                                          "Use GTK Background color",
                                                          TRUE,
                                                          G_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class,
+                                   PROP_MAX_STATUSES,
+                                   g_param_spec_int ("max-statuses",
+                                                     "Max Statuses",
+                                                     "Maximum number of statuses kept, or 0 for no limit",
+                                                     0, G_MAXINT,
+                                                     200,
+                                                     G_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class,
+                                   PROP_MAX_STATUS_AGE,
+                                   g_param_spec_int ("max-status-age",
+                                                     "Max Status Age",
+                                                     "Maximum age of the statuses kept, in seconds, or 0 for no limit",
+                                                     0, G_MAXINT,
+                                                     0,
+                                                     G_PARAM_READWRITE));
 
   config_signals[CHANGED] =
     g_signal_new (g_intern_static_string ("changed"),
@@ -200,6 +237,8 @@ tweet_config_init (TweetConfig *config)
 
   config->priv->refresh_time = 300;
   config->priv->use_gtk_bg = TRUE;
+  config->priv->max_statuses = 200;
+  config->priv->max_status_age = 0;
 }
 
 TweetConfig *
@@ -350,6 +389,58 @@ tweet_config_get_use_gtk_bg (TweetConfig *config)
   return config->priv->use_gtk_bg;
 }
 
+void
+tweet_config_set_max_statuses (TweetConfig *config,
+                               gint         max_statuses)
+{
+  TweetConfigPrivate *priv;
+
+  g_return_if_fail (TWEET_IS_CONFIG (config));
+
+  priv = config->priv;
+
+  if (priv->max_statuses != max_statuses)
+    {
+      priv->max_statuses = max_statuses;
+
+      g_object_notify (G_OBJECT (config), "max-statuses");
+    }
+}
+
+gint
+tweet_config_get_max_statuses (TweetConfig *config)
+{
+  g_return_val_if_fail (TWEET_IS_CONFIG (config), 0);
+
+  return config->priv->max_statuses;
+}
+
+void
+tweet_config_set_max_status_age (TweetConfig *config,
+                                 gint         seconds)
+{
+  TweetConfigPrivate *priv;
+
+  g_return_if_fail (TWEET_IS_CONFIG (config));
+
+  priv = config->priv;
+
+  if (priv->max_status_age != seconds)
+    {
+      priv->max_status_age = seconds;
+
+      g_object_notify (G_OBJECT (config), "max-status-age");
+    }
+}
+
+gint
+tweet_config_get_max_status_age (TweetConfig *config)
+{
+  g_return_val_if_fail (TWEET_IS_CONFIG (config), 0);
+
+  return config->priv->max_status_age;
+}
+
 void
 tweet_config_save (TweetConfig *config)
 {
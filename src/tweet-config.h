@@ -66,6 +66,13 @@ gboolean              tweet_config_get_use_gtk_bg   (TweetConfig *config);
 void                  tweet_config_set_use_gtk_bg   (TweetConfig *config,
                                                      gboolean     value);
 
+void                  tweet_config_set_max_statuses   (TweetConfig *config,
+                                                       gint         max_statuses);
+gint                  tweet_config_get_max_statuses   (TweetConfig *config);
+void                  tweet_config_set_max_status_age (TweetConfig *config,
+                                                       gint         seconds);
+gint                  tweet_config_get_max_status_age (TweetConfig *config);
+
 void                  tweet_config_save         (TweetConfig *config);
 
 G_END_DECLS
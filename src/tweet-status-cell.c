@@ -34,6 +34,7 @@
 
 #include <twitter-glib/twitter-glib.h>
 
+#include "tweet-avatar.h"
 #include "tweet-status-cell.h"
 #include "tweet-utils.h"
 #include "tweet-url-label.h"
@@ -44,7 +45,9 @@
 #define V_PADDING       6
 #define H_PADDING       12
 
-#define DEFAULT_WIDTH   (96 + (2 * H_PADDING) + 230)
+#define TEXT_WIDTH      230
+
+#define DEFAULT_WIDTH   (96 + (2 * H_PADDING) + TEXT_WIDTH)
 #define DEFAULT_HEIGHT  (72 + (2 * V_PADDING))
 
 #define ICON_X          (H_PADDING / 2)
@@ -60,7 +63,8 @@ enum
   PROP_0,
 
   PROP_STATUS,
-  PROP_FONT_NAME
+  PROP_FONT_NAME,
+  PROP_WIDTH
 };
 
 G_DEFINE_TYPE (TweetStatusCell, tweet_status_cell, CLUTTER_TYPE_GROUP);
@@ -105,6 +109,10 @@ tweet_status_cell_set_property (GObject      *gobject,
       cell->font_name = g_value_dup_string (value);
       break;
 
+    case PROP_WIDTH:
+      cell->width = g_value_get_int (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -129,44 +137,38 @@ tweet_status_cell_get_property (GObject    *gobject,
       g_value_set_string (value, cell->font_name);
       break;
 
+    case PROP_WIDTH:
+      g_value_set_int (value, cell->width);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
     }
 }
 
-static void
-tweet_status_cell_constructed (GObject *gobject)
+static gchar *
+tweet_status_cell_build_text (TwitterStatus *status,
+                              GRegex        *escape_re)
 {
-  TweetStatusCell *cell = TWEET_STATUS_CELL (gobject);
-  cairo_t *cr;
-  cairo_pattern_t *pat;
-  ClutterColor bg_color = { 162, 162, 162, 0xcc };
-  ClutterColor text_color = { 0, 0, 0, 255 };
   TwitterUser *user;
   gchar *text, *created_at, *escaped;
   GTimeVal timeval = { 0, };
-  GdkPixbuf *pixbuf = NULL;
-  gint width = DEFAULT_WIDTH;
-  gint height = DEFAULT_HEIGHT;
-
-  g_assert (TWITTER_IS_STATUS (cell->status));
 
-  user = twitter_status_get_user (cell->status);
-  g_assert (TWITTER_IS_USER (user));
+  user = twitter_status_get_user (status);
 
   /* some twitter client doesn't escape bare '&' properly, so we get
    * failures from the pango markup parser. we need to replace the
    * '&\s' with corresponding '&amp; '.
    */
-  escaped = g_regex_replace (cell->escape_re,
-                             twitter_status_get_text (cell->status), -1,
+  escaped = g_regex_replace (escape_re,
+                             twitter_status_get_text (status), -1,
                              0,
                              "&amp;",
                              0,
                              NULL);
 
-  twitter_date_to_time_val (twitter_status_get_created_at (cell->status), &timeval);
+  twitter_date_to_time_val (twitter_status_get_created_at (status), &timeval);
 
   created_at = tweet_format_time_for_display (&timeval);
   text = g_strdup_printf ("<b>%s</b> %s\n\n<small>%s</small>",
@@ -176,46 +178,73 @@ tweet_status_cell_constructed (GObject *gobject)
   g_free (created_at);
   g_free (escaped);
 
-  cell->label = clutter_label_new ();
-  clutter_label_set_color (CLUTTER_LABEL (cell->label), &text_color);
-  clutter_label_set_font_name (CLUTTER_LABEL (cell->label), cell->font_name);
-  clutter_label_set_line_wrap (CLUTTER_LABEL (cell->label), TRUE);
-  clutter_label_set_line_wrap_mode (CLUTTER_LABEL (cell->label), PANGO_WRAP_WORD_CHAR);
-  clutter_label_set_text (CLUTTER_LABEL (cell->label), text);
-  clutter_label_set_use_markup (CLUTTER_LABEL (cell->label), TRUE);
-  clutter_actor_set_position (cell->label, TEXT_X, TEXT_Y);
-  clutter_actor_set_size (cell->label, 230, 1);
-  clutter_actor_show (cell->label);
+  return text;
+}
 
-  height =
-    MAX (DEFAULT_HEIGHT, clutter_actor_get_height (cell->label) + 2 * V_PADDING);
+/* the text wraps at the width left by the icon and the padding; the
+ * cell never grows past its default width, since the background is
+ * drawn at that width
+ */
+static gint
+tweet_status_cell_get_text_width (gint width)
+{
+  if (width <= 0 || width > DEFAULT_WIDTH)
+    width = DEFAULT_WIDTH;
 
-  g_free (text);
+  return MAX (1, width - (DEFAULT_WIDTH - TEXT_WIDTH));
+}
 
-  /* icon */
-  pixbuf = twitter_user_get_profile_image (user);
-  if (pixbuf)
-    cell->icon = tweet_texture_new_from_pixbuf (pixbuf);
-  else
-    {
-      cell->icon = clutter_rectangle_new ();
-      clutter_rectangle_set_color (CLUTTER_RECTANGLE (cell->icon), &text_color);
-    }
+static void
+tweet_status_cell_setup_label (ClutterActor *label,
+                               const gchar  *font_name,
+                               const gchar  *text,
+                               gint          width)
+{
+  ClutterColor text_color = { 0, 0, 0, 255 };
 
-  clutter_actor_set_size (cell->icon, ICON_WIDTH, ICON_HEIGHT);
-  clutter_actor_set_position (cell->icon,
-                              ICON_X,
-                              (height - ICON_HEIGHT) / 2);
-  clutter_actor_show (cell->icon);
-  clutter_actor_set_reactive (cell->icon, TRUE);
+  clutter_label_set_color (CLUTTER_LABEL (label), &text_color);
+  clutter_label_set_font_name (CLUTTER_LABEL (label), font_name);
+  clutter_label_set_line_wrap (CLUTTER_LABEL (label), TRUE);
+  clutter_label_set_line_wrap_mode (CLUTTER_LABEL (label), PANGO_WRAP_WORD_CHAR);
+  clutter_label_set_text (CLUTTER_LABEL (label), text);
+  clutter_label_set_use_markup (CLUTTER_LABEL (label), TRUE);
+  clutter_actor_set_size (label, tweet_status_cell_get_text_width (width), 1);
+}
 
-  cell->cell_height = CLUTTER_UNITS_FROM_DEVICE (height);
+typedef struct
+{
+  ClutterActor *bg;
+  ClutterActor *bubble;
+} CellBackground;
+
+/* the background and the bubble only depend on the height of the
+ * cell, since the width and the colours are fixed; they are drawn
+ * once for each height and shared by every cell of that height
+ */
+static GHashTable *backgrounds = NULL;
+
+static CellBackground *
+tweet_status_cell_get_background (gint height)
+{
+  CellBackground *background;
+  cairo_t *cr;
+  cairo_pattern_t *pat;
+  ClutterColor bg_color = { 162, 162, 162, 0xcc };
+  gint width = DEFAULT_WIDTH;
+
+  if (G_UNLIKELY (backgrounds == NULL))
+    backgrounds = g_hash_table_new (NULL, NULL);
+
+  background = g_hash_table_lookup (backgrounds, GINT_TO_POINTER (height));
+  if (background)
+    return background;
+
+  background = g_slice_new (CellBackground);
 
   /* background texture */
-  cell->bg = clutter_cairo_new (width, height);
-  clutter_actor_show (cell->bg);
+  background->bg = g_object_ref_sink (clutter_cairo_new (width, height));
 
-  cr = clutter_cairo_create (CLUTTER_CAIRO (cell->bg));
+  cr = clutter_cairo_create (CLUTTER_CAIRO (background->bg));
   g_assert (cr != NULL);
 
   width = DEFAULT_WIDTH - (H_PADDING / 2);
@@ -238,11 +267,9 @@ tweet_status_cell_constructed (GObject *gobject)
   cairo_destroy (cr);
 
   /* bubble texture */
-  cell->bubble = clutter_cairo_new (width, height);
-  clutter_actor_set_position (cell->bubble, TEXT_X - H_PADDING, 0);
-  clutter_actor_show (cell->bubble);
+  background->bubble = g_object_ref_sink (clutter_cairo_new (width, height));
 
-  cr = clutter_cairo_create (CLUTTER_CAIRO (cell->bubble));
+  cr = clutter_cairo_create (CLUTTER_CAIRO (background->bubble));
   g_assert (cr != NULL);
 
   pat = cairo_pattern_create_linear (0, 0, 0, height);
@@ -292,6 +319,119 @@ tweet_status_cell_constructed (GObject *gobject)
   cairo_pattern_destroy (pat);
   cairo_destroy (cr);
 
+  /* the clones paint the textures of their parent */
+  clutter_actor_realize (background->bg);
+  clutter_actor_realize (background->bubble);
+
+  g_hash_table_insert (backgrounds, GINT_TO_POINTER (height), background);
+
+  return background;
+}
+
+/* creates the background and the bubble of the cell, cloning the
+ * shared textures for the height of the cell
+ */
+static void
+tweet_status_cell_draw_background (TweetStatusCell *cell,
+                                   gint             height)
+{
+  CellBackground *background;
+
+  background = tweet_status_cell_get_background (height);
+
+  cell->bg = clutter_clone_texture_new (CLUTTER_TEXTURE (background->bg));
+  clutter_actor_set_size (cell->bg,
+                          clutter_actor_get_width (background->bg),
+                          height);
+  clutter_actor_show (cell->bg);
+
+  cell->bubble =
+    clutter_clone_texture_new (CLUTTER_TEXTURE (background->bubble));
+  clutter_actor_set_size (cell->bubble,
+                          clutter_actor_get_width (background->bubble),
+                          height);
+  clutter_actor_set_position (cell->bubble, TEXT_X - H_PADDING, 0);
+  clutter_actor_show (cell->bubble);
+}
+
+/* sets the icon of the cell using the profile image of @user, or a
+ * placeholder if the image has not been loaded yet
+ */
+static void
+tweet_status_cell_set_icon (TweetStatusCell *cell,
+                            TwitterUser     *user,
+                            gint             height)
+{
+  ClutterColor text_color = { 0, 0, 0, 255 };
+  ClutterActor *icon = cell->icon;
+  const gchar *url;
+  GdkPixbuf *pixbuf;
+
+  /* the download is cancelled if we get destroyed first */
+  pixbuf = twitter_user_request_profile_image (user, G_OBJECT (cell), TRUE);
+  url = twitter_user_get_profile_image_url (user);
+  if (pixbuf && url)
+    {
+      /* the avatars of the same user share a single texture */
+      if (icon && tweet_is_avatar (icon))
+        tweet_avatar_set_image (icon, url, pixbuf);
+      else
+        icon = tweet_avatar_new (url, pixbuf);
+    }
+  else if (!icon || !CLUTTER_IS_RECTANGLE (icon))
+    {
+      icon = clutter_rectangle_new ();
+      clutter_rectangle_set_color (CLUTTER_RECTANGLE (icon), &text_color);
+    }
+
+  if (icon != cell->icon)
+    {
+      if (cell->icon)
+        clutter_actor_destroy (cell->icon);
+
+      cell->icon = icon;
+      clutter_actor_set_reactive (cell->icon, TRUE);
+      clutter_actor_show (cell->icon);
+    }
+
+  clutter_actor_set_size (cell->icon, ICON_WIDTH, ICON_HEIGHT);
+  clutter_actor_set_position (cell->icon,
+                              ICON_X,
+                              (height - ICON_HEIGHT) / 2);
+}
+
+static void
+tweet_status_cell_constructed (GObject *gobject)
+{
+  TweetStatusCell *cell = TWEET_STATUS_CELL (gobject);
+  TwitterUser *user;
+  gchar *text;
+  gint height = DEFAULT_HEIGHT;
+
+  g_assert (TWITTER_IS_STATUS (cell->status));
+
+  user = twitter_status_get_user (cell->status);
+  g_assert (TWITTER_IS_USER (user));
+
+  text = tweet_status_cell_build_text (cell->status, cell->escape_re);
+
+  cell->label = clutter_label_new ();
+  tweet_status_cell_setup_label (cell->label, cell->font_name, text,
+                                 cell->width);
+  clutter_actor_set_position (cell->label, TEXT_X, TEXT_Y);
+  clutter_actor_show (cell->label);
+
+  height =
+    MAX (DEFAULT_HEIGHT, clutter_actor_get_height (cell->label) + 2 * V_PADDING);
+
+  g_free (text);
+
+  tweet_status_cell_set_icon (cell, user, height);
+
+  cell->cell_height = CLUTTER_UNITS_FROM_DEVICE (height);
+
+  tweet_status_cell_draw_background (cell, height);
+
   /* we add them in the right order */
   clutter_container_add (CLUTTER_CONTAINER (cell),
                          cell->bg,
@@ -338,6 +478,13 @@ tweet_status_cell_class_init (TweetStatusCellClass *klass)
                                                         "Twitter status",
                                                         TWITTER_TYPE_STATUS,
                                                         G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class,
+                                   PROP_WIDTH,
+                                   g_param_spec_int ("width",
+                                                     "Width",
+                                                     "The width available to the cell, or -1",
+                                                     -1, G_MAXINT, -1,
+                                                     G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE));
 }
 
 static void
@@ -346,14 +493,111 @@ tweet_status_cell_init (TweetStatusCell *cell)
   cell->escape_re = g_regex_new ("&(?!(amp|gt|lt|apos))", 0, 0, NULL);
 }
 
+/* rebinds @cell to @status, updating the text and the icon; the
+ * textures are only drawn again if the height of the cell changes
+ */
+void
+tweet_status_cell_set_status (TweetStatusCell *cell,
+                              TwitterStatus   *status)
+{
+  ClutterActor *old_icon;
+  TwitterUser *user;
+  gchar *text;
+  gint height, old_height;
+
+  g_return_if_fail (TWEET_IS_STATUS_CELL (cell));
+  g_return_if_fail (TWITTER_IS_STATUS (status));
+
+  user = twitter_status_get_user (status);
+  g_assert (TWITTER_IS_USER (user));
+
+  if (status != cell->status)
+    {
+      TwitterUser *old_user = twitter_status_get_user (cell->status);
+
+      /* we don't need the profile image of the previous user */
+      if (old_user != user)
+        twitter_user_release_profile_image (old_user, G_OBJECT (cell));
+
+      g_object_unref (cell->status);
+      cell->status = g_object_ref (status);
+    }
+
+  text = tweet_status_cell_build_text (cell->status, cell->escape_re);
+  tweet_status_cell_setup_label (cell->label, cell->font_name, text,
+                                 cell->width);
+  g_free (text);
+
+  height =
+    MAX (DEFAULT_HEIGHT, clutter_actor_get_height (cell->label) + 2 * V_PADDING);
+  old_height = CLUTTER_UNITS_TO_DEVICE (cell->cell_height);
+
+  old_icon = cell->icon;
+  tweet_status_cell_set_icon (cell, user, height);
+  if (cell->icon != old_icon)
+    {
+      clutter_container_add_actor (CLUTTER_CONTAINER (cell), cell->icon);
+      clutter_actor_lower (cell->icon, cell->bubble);
+    }
+
+  /* the clones just switch to the shared textures of the new height */
+  if (height != old_height)
+    {
+      CellBackground *background;
+
+      background = tweet_status_cell_get_background (height);
+
+      clutter_clone_texture_set_parent_texture (CLUTTER_CLONE_TEXTURE (cell->bg),
+                                                CLUTTER_TEXTURE (background->bg));
+      clutter_actor_set_height (cell->bg, height);
+
+      clutter_clone_texture_set_parent_texture (CLUTTER_CLONE_TEXTURE (cell->bubble),
+                                                CLUTTER_TEXTURE (background->bubble));
+      clutter_actor_set_height (cell->bubble, height);
+
+      cell->cell_height = CLUTTER_UNITS_FROM_DEVICE (height);
+    }
+
+  g_object_notify (G_OBJECT (cell), "status");
+}
+
 ClutterActor *
 tweet_status_cell_new (TwitterStatus *status,
-                       const gchar   *font_name)
+                       const gchar   *font_name,
+                       gint           width)
 {
   g_return_val_if_fail (TWITTER_IS_STATUS (status), NULL);
 
   return g_object_new (TWEET_TYPE_STATUS_CELL,
                        "status", status,
                        "font-name", font_name,
+                       "width", width,
                        NULL);
 }
+
+/* computes the height of the cell for @status at @width without
+ * creating it, by laying out the text of the status on @measure_label,
+ * a label that is never painted; used by the renderer to measure the
+ * rows
+ */
+ClutterUnit
+tweet_status_cell_get_height_for_status (TwitterStatus *status,
+                                         const gchar   *font_name,
+                                         gint           width,
+                                         ClutterActor  *measure_label,
+                                         GRegex        *escape_re)
+{
+  gchar *text;
+  gint height;
+
+  g_return_val_if_fail (TWITTER_IS_STATUS (status), 0);
+  g_return_val_if_fail (CLUTTER_IS_LABEL (measure_label), 0);
+
+  text = tweet_status_cell_build_text (status, escape_re);
+  tweet_status_cell_setup_label (measure_label, font_name, text, width);
+  g_free (text);
+
+  height = clutter_actor_get_height (measure_label) + 2 * V_PADDING;
+
+  return CLUTTER_UNITS_FROM_DEVICE (MAX (DEFAULT_HEIGHT, height));
+}
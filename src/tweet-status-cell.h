@@ -49,6 +49,9 @@ struct _TweetStatusCell
 
   TwitterStatus *status;
 
+  /* the width the cell was created for, or -1 */
+  gint width;
+
   ClutterUnit cell_height;
 };
 
@@ -59,7 +62,16 @@ struct _TweetStatusCellClass
 
 GType         tweet_status_cell_get_type (void) G_GNUC_CONST;
 ClutterActor *tweet_status_cell_new      (TwitterStatus *status,
-                                          const gchar   *font_name);
+                                          const gchar   *font_name,
+                                          gint           width);
+void          tweet_status_cell_set_status (TweetStatusCell *cell,
+                                            TwitterStatus   *status);
+
+ClutterUnit   tweet_status_cell_get_height_for_status (TwitterStatus *status,
+                                                       const gchar   *font_name,
+                                                       gint           width,
+                                                       ClutterActor  *measure_label,
+                                                       GRegex        *escape_re);
 
 G_END_DECLS
 
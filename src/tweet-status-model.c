@@ -58,23 +58,78 @@ struct _TweetStatusModelIter
   ClutterModelIter parent_instance;
 
   GSequenceIter *seq_iter;
+
+  /* the row is kept here, instead of the ClutterModelIter:row
+   * property, so that stepping the iterator does not go through
+   * the GObject property machinery
+   */
+  guint row;
+};
+
+enum
+{
+  PROP_ITER_0,
+
+  PROP_ITER_ROW
 };
 
 #define TWEET_STATUS_MODEL_GET_PRIVATE(obj)     (G_TYPE_INSTANCE_GET_PRIVATE ((obj), TWEET_TYPE_STATUS_MODEL, TweetStatusModelPrivate))
 
 struct _TweetStatusModelPrivate
 {
+  /* the model has a single column, so every item of the sequence
+   * is a reference on the TwitterStatus of the row
+   */
   GSequence *sequence;
 
+  /* reused every time a row has to be filtered */
+  TweetStatusModelIter *filter_iter;
+
+  /* the rows passing the filter, in the same order as the model;
+   * each item is the GSequenceIter of the row inside the model. the
+   * filter is only run again when a row is set or changed, or when
+   * the filter itself changes
+   */
+  GSequence *visible_rows;
+  GHashTable *visible_by_row;
+
+  /* status id -> GSequenceIter; the iterators stay valid when the
+   * sequence is sorted, so the index only changes when a row is
+   * added, removed or set
+   */
+  GHashTable *status_by_id;
+
+  /* rows changed since the last frame */
+  GHashTable *changed_rows;
+  guint changed_id;
+
+  /* limits on the rows; the oldest rows are at the end */
   gint max_size;
+  gint max_age;
+  guint expire_id;
+};
+
+/* how often the rows older than the maximum age are removed */
+#define EXPIRE_INTERVAL         60
+
+enum
+{
+  ROWS_CHANGED,
+
+  LAST_SIGNAL
 };
 
+static guint model_signals[LAST_SIGNAL] = { 0, };
+
 static const gchar *model_names[] = {
   "Status"
 };
 
 static const gint model_columns = G_N_ELEMENTS (model_names);
 
+static void status_changed_cb (TwitterStatus    *status,
+                               TweetStatusModel *model);
+
 
 
 /*
@@ -85,57 +140,230 @@ G_DEFINE_TYPE (TweetStatusModelIter,
                tweet_status_model_iter,
                CLUTTER_TYPE_MODEL_ITER);
 
+static void
+tweet_status_model_unindex_status (TweetStatusModel *model,
+                                   GSequenceIter    *seq_iter,
+                                   TwitterStatus    *status)
+{
+  TweetStatusModelPrivate *priv = model->priv;
+  gpointer status_id;
+
+  if (!status)
+    return;
+
+  g_signal_handlers_disconnect_by_func (status,
+                                        G_CALLBACK (status_changed_cb),
+                                        model);
+
+  status_id = GUINT_TO_POINTER (twitter_status_get_id (status));
+  if (g_hash_table_lookup (priv->status_by_id, status_id) == seq_iter)
+    g_hash_table_remove (priv->status_by_id, status_id);
+}
+
+static void
+tweet_status_model_index_status (TweetStatusModel *model,
+                                 GSequenceIter    *seq_iter,
+                                 TwitterStatus    *status)
+{
+  TweetStatusModelPrivate *priv = model->priv;
+
+  if (!status)
+    return;
+
+  g_hash_table_replace (priv->status_by_id,
+                        GUINT_TO_POINTER (twitter_status_get_id (status)),
+                        seq_iter);
+
+  g_signal_connect (status, "changed",
+                    G_CALLBACK (status_changed_cb),
+                    model);
+}
+
+/* updates the row of an iterator */
+static inline void
+tweet_status_model_iter_set_row (TweetStatusModelIter *iter,
+                                 guint                 row)
+{
+  iter->row = row;
+}
+
+/* filters the row at @seq_iter, without creating a new iterator */
+static gboolean
+tweet_status_model_filter_seq (ClutterModel  *model,
+                               GSequenceIter *seq_iter,
+                               guint          row)
+{
+  TweetStatusModelPrivate *priv = TWEET_STATUS_MODEL (model)->priv;
+
+  if (G_UNLIKELY (priv->filter_iter == NULL))
+    priv->filter_iter = g_object_new (TWEET_TYPE_STATUS_MODEL_ITER,
+                                      "model", model,
+                                      NULL);
+
+  priv->filter_iter->seq_iter = seq_iter;
+  tweet_status_model_iter_set_row (priv->filter_iter, row);
+
+  return clutter_model_filter_iter (model,
+                                    CLUTTER_MODEL_ITER (priv->filter_iter));
+}
+
+static gint
+compare_rows (gconstpointer a,
+              gconstpointer b,
+              gpointer      data)
+{
+  return g_sequence_iter_compare ((GSequenceIter *) a, (GSequenceIter *) b);
+}
+
+/* runs the filter on the row at @seq_iter and updates its visibility */
+static void
+tweet_status_model_update_visible (TweetStatusModel *model,
+                                   GSequenceIter    *seq_iter)
+{
+  TweetStatusModelPrivate *priv = model->priv;
+  GSequenceIter *visible_iter;
+  gboolean is_visible = FALSE;
+
+  /* a row without a status is still being added */
+  if (g_sequence_get (seq_iter) != NULL)
+    is_visible = tweet_status_model_filter_seq (CLUTTER_MODEL (model),
+                                                seq_iter,
+                                                g_sequence_iter_get_position (seq_iter));
+
+  visible_iter = g_hash_table_lookup (priv->visible_by_row, seq_iter);
+
+  if (is_visible && visible_iter == NULL)
+    {
+      visible_iter = g_sequence_insert_sorted (priv->visible_rows, seq_iter,
+                                               compare_rows,
+                                               NULL);
+      g_hash_table_insert (priv->visible_by_row, seq_iter, visible_iter);
+    }
+  else if (!is_visible && visible_iter != NULL)
+    {
+      g_sequence_remove (visible_iter);
+      g_hash_table_remove (priv->visible_by_row, seq_iter);
+    }
+}
+
+/* rebuilds the list of visible rows; if @refilter is FALSE only the
+ * order of the rows changed, so the filter is not run again
+ */
+static void
+tweet_status_model_rebuild_visible (TweetStatusModel *model,
+                                    gboolean          refilter)
+{
+  TweetStatusModelPrivate *priv = model->priv;
+  GSequenceIter *seq_iter;
+  GSequence *visible_rows;
+  guint row = 0;
+
+  visible_rows = g_sequence_new (NULL);
+
+  seq_iter = g_sequence_get_begin_iter (priv->sequence);
+  while (!g_sequence_iter_is_end (seq_iter))
+    {
+      gboolean is_visible;
+
+      if (refilter)
+        is_visible = g_sequence_get (seq_iter) != NULL &&
+                     tweet_status_model_filter_seq (CLUTTER_MODEL (model),
+                                                    seq_iter,
+                                                    row);
+      else
+        is_visible = g_hash_table_lookup (priv->visible_by_row, seq_iter) != NULL;
+
+      if (is_visible)
+        g_hash_table_replace (priv->visible_by_row, seq_iter,
+                              g_sequence_append (visible_rows, seq_iter));
+      else
+        g_hash_table_remove (priv->visible_by_row, seq_iter);
+
+      seq_iter = g_sequence_iter_next (seq_iter);
+      row += 1;
+    }
+
+  g_sequence_free (priv->visible_rows);
+  priv->visible_rows = visible_rows;
+}
+
+/* the first visible row after @seq_iter, or the end iterator */
+static GSequenceIter *
+tweet_status_model_next_visible (TweetStatusModel *model,
+                                 GSequenceIter    *seq_iter)
+{
+  TweetStatusModelPrivate *priv = model->priv;
+  GSequenceIter *visible_iter;
+
+  visible_iter = g_hash_table_lookup (priv->visible_by_row, seq_iter);
+  if (visible_iter != NULL)
+    visible_iter = g_sequence_iter_next (visible_iter);
+  else
+    visible_iter = g_sequence_search (priv->visible_rows, seq_iter,
+                                      compare_rows,
+                                      NULL);
+
+  if (g_sequence_iter_is_end (visible_iter))
+    return g_sequence_get_end_iter (priv->sequence);
+
+  return g_sequence_get (visible_iter);
+}
+
+/* the last visible row before @seq_iter, or the begin iterator */
+static GSequenceIter *
+tweet_status_model_prev_visible (TweetStatusModel *model,
+                                 GSequenceIter    *seq_iter)
+{
+  TweetStatusModelPrivate *priv = model->priv;
+  GSequenceIter *visible_iter;
+
+  visible_iter = g_hash_table_lookup (priv->visible_by_row, seq_iter);
+  if (visible_iter == NULL)
+    visible_iter = g_sequence_search (priv->visible_rows, seq_iter,
+                                      compare_rows,
+                                      NULL);
+
+  if (g_sequence_iter_is_begin (visible_iter))
+    return g_sequence_get_begin_iter (priv->sequence);
+
+  return g_sequence_get (g_sequence_iter_prev (visible_iter));
+}
+
 static void
 tweet_status_model_iter_get_value (ClutterModelIter *iter,
                                    guint             column,
                                    GValue           *value)
 {
   TweetStatusModelIter *iter_default;
-  GValueArray *value_array;
-  GValue *iter_value;
-  GValue real_value = { 0, };
-  gboolean converted = FALSE;
+  TwitterStatus *status;
+  GValue status_value = { 0, };
 
   iter_default = TWEET_STATUS_MODEL_ITER (iter);
   g_assert (iter_default->seq_iter != NULL);
+  g_assert (column == 0);
 
-  value_array = g_sequence_get (iter_default->seq_iter);
-  iter_value = g_value_array_get_nth (value_array, column);
-  g_assert (iter_value != NULL);
+  status = g_sequence_get (iter_default->seq_iter);
 
-  if (!g_type_is_a (G_VALUE_TYPE (value), G_VALUE_TYPE (iter_value)))
+  /* fast path: no conversion needed */
+  if (G_LIKELY (g_type_is_a (TWITTER_TYPE_STATUS, G_VALUE_TYPE (value))))
     {
-      if (!g_value_type_compatible (G_VALUE_TYPE (value), 
-                                    G_VALUE_TYPE (iter_value)) &&
-          !g_value_type_compatible (G_VALUE_TYPE (iter_value), 
-                                    G_VALUE_TYPE (value)))
-        {
-          g_warning ("%s: Unable to convert from %s to %s",
-                     G_STRLOC,
-                     g_type_name (G_VALUE_TYPE (value)),
-                     g_type_name (G_VALUE_TYPE (iter_value)));
-          return;
-        }
+      g_value_set_object (value, status);
+      return;
+    }
 
-      if (!g_value_transform (iter_value, &real_value))
-        {
-          g_warning ("%s: Unable to make conversion from %s to %s",
-                     G_STRLOC, 
-                     g_type_name (G_VALUE_TYPE (value)),
-                     g_type_name (G_VALUE_TYPE (iter_value)));
-          g_value_unset (&real_value);
-        }
+  g_value_init (&status_value, TWITTER_TYPE_STATUS);
+  g_value_set_object (&status_value, status);
 
-      converted = TRUE;
-    }
-  
-  if (converted)
+  if (!g_value_type_transformable (TWITTER_TYPE_STATUS, G_VALUE_TYPE (value)) ||
+      !g_value_transform (&status_value, value))
     {
-      g_value_copy (&real_value, value);
-      g_value_unset (&real_value);
+      g_warning ("%s: Unable to convert from %s to %s",
+                 G_STRLOC,
+                 g_type_name (TWITTER_TYPE_STATUS),
+                 g_type_name (G_VALUE_TYPE (value)));
     }
-  else
-    g_value_copy (iter_value, value);
+
+  g_value_unset (&status_value);
 }
 
 static void
@@ -144,108 +372,84 @@ tweet_status_model_iter_set_value (ClutterModelIter *iter,
                                    const GValue     *value)
 {
   TweetStatusModelIter *iter_default;
-  GValueArray *value_array;
-  GValue *iter_value;
-  GValue real_value = { 0, };
-  gboolean converted = FALSE;
+  TweetStatusModel *model;
+  TwitterStatus *old_status, *new_status;
+  GValue status_value = { 0, };
 
   iter_default = TWEET_STATUS_MODEL_ITER (iter);
   g_assert (iter_default->seq_iter != NULL);
+  g_assert (column == 0);
 
-  value_array = g_sequence_get (iter_default->seq_iter);
-  iter_value = g_value_array_get_nth (value_array, column);
-  g_assert (iter_value != NULL);
-
-  if (!g_type_is_a (G_VALUE_TYPE (value), G_VALUE_TYPE (iter_value)))
+  if (G_LIKELY (g_type_is_a (G_VALUE_TYPE (value), TWITTER_TYPE_STATUS)))
+    new_status = g_value_get_object (value);
+  else
     {
-      if (!g_value_type_compatible (G_VALUE_TYPE (value), 
-                                    G_VALUE_TYPE (iter_value)) &&
-          !g_value_type_compatible (G_VALUE_TYPE (iter_value), 
-                                    G_VALUE_TYPE (value)))
+      g_value_init (&status_value, TWITTER_TYPE_STATUS);
+
+      if (!g_value_type_transformable (G_VALUE_TYPE (value), TWITTER_TYPE_STATUS) ||
+          !g_value_transform (value, &status_value))
         {
           g_warning ("%s: Unable to convert from %s to %s\n",
                      G_STRLOC,
                      g_type_name (G_VALUE_TYPE (value)),
-                     g_type_name (G_VALUE_TYPE (iter_value)));
+                     g_type_name (TWITTER_TYPE_STATUS));
+          g_value_unset (&status_value);
           return;
         }
 
-      if (!g_value_transform (value, &real_value))
-        {
-          g_warning ("%s: Unable to make conversion from %s to %s\n",
-                     G_STRLOC, 
-                     g_type_name (G_VALUE_TYPE (value)),
-                     g_type_name (G_VALUE_TYPE (iter_value)));
-          g_value_unset (&real_value);
-        }
-
-      converted = TRUE;
-    }
- 
-  if (converted)
-    {
-      g_value_copy (&real_value, iter_value);
-      g_value_unset (&real_value);
+      new_status = g_value_get_object (&status_value);
     }
-  else
-    g_value_copy (value, iter_value);
+
+  if (new_status)
+    g_object_ref (new_status);
+
+  model = TWEET_STATUS_MODEL (clutter_model_iter_get_model (iter));
+  old_status = g_sequence_get (iter_default->seq_iter);
+
+  /* keep the index in sync with the rows */
+  tweet_status_model_unindex_status (model, iter_default->seq_iter,
+                                     old_status);
+
+  g_sequence_set (iter_default->seq_iter, new_status);
+
+  tweet_status_model_index_status (model, iter_default->seq_iter,
+                                   new_status);
+
+  tweet_status_model_update_visible (model, iter_default->seq_iter);
+
+  if (old_status)
+    g_object_unref (old_status);
+
+  if (G_IS_VALUE (&status_value))
+    g_value_unset (&status_value);
 }
 
 static gboolean
 tweet_status_model_iter_is_first (ClutterModelIter *iter)
 {
   TweetStatusModelIter *iter_default;
-  ClutterModel *model;
-  ClutterModelIter *temp_iter;
-  GSequenceIter *begin, *end;
-  guint row;
+  TweetStatusModelPrivate *priv;
+  GSequenceIter *first;
 
   iter_default = TWEET_STATUS_MODEL_ITER (iter);
   g_assert (iter_default->seq_iter != NULL);
 
-  model = clutter_model_iter_get_model (iter);
-  row   = clutter_model_iter_get_row (iter);
-
-  begin = g_sequence_get_begin_iter (TWEET_STATUS_MODEL (model)->priv->sequence);
-  end   = iter_default->seq_iter;
-
-  temp_iter = g_object_new (TWEET_TYPE_STATUS_MODEL_ITER,
-                            "model", model,
-                            NULL);
-
-  while (!g_sequence_iter_is_begin (begin))
-    {
-      TWEET_STATUS_MODEL_ITER (temp_iter)->seq_iter = begin;
-      g_object_set (G_OBJECT (temp_iter), "row", row, NULL);
-
-      if (clutter_model_filter_iter (model, temp_iter))
-        {
-          end = begin;
-          break;
-        }
-
-      begin = g_sequence_iter_next (begin);
-      row += 1;
-    }
+  priv = TWEET_STATUS_MODEL (clutter_model_iter_get_model (iter))->priv;
 
-  g_object_unref (temp_iter);
+  if (g_sequence_get_length (priv->visible_rows) == 0)
+    return g_sequence_iter_is_begin (iter_default->seq_iter);
 
-  /* This is because the 'begin_iter' is always *before* the last valid
-   * iter, otherwise we'd have endless loops 
-   */
-  end = g_sequence_iter_prev (end);
+  first = g_sequence_get (g_sequence_get_begin_iter (priv->visible_rows));
 
-  return iter_default->seq_iter == end;
+  return iter_default->seq_iter == first;
 }
 
 static gboolean
 tweet_status_model_iter_is_last (ClutterModelIter *iter)
 {
   TweetStatusModelIter *iter_default;
-  ClutterModelIter *temp_iter;
-  ClutterModel *model;
-  GSequenceIter *begin, *end;
-  guint row;
+  TweetStatusModelPrivate *priv;
+  GSequenceIter *last;
 
   iter_default = TWEET_STATUS_MODEL_ITER (iter);
   g_assert (iter_default->seq_iter != NULL);
@@ -253,86 +457,38 @@ tweet_status_model_iter_is_last (ClutterModelIter *iter)
   if (g_sequence_iter_is_end (iter_default->seq_iter))
     return TRUE;
 
-  model = clutter_model_iter_get_model (iter);
-  row   = clutter_model_iter_get_row (iter);
+  priv = TWEET_STATUS_MODEL (clutter_model_iter_get_model (iter))->priv;
 
-  begin = g_sequence_get_end_iter (TWEET_STATUS_MODEL (model)->priv->sequence);
-  begin = g_sequence_iter_prev (begin);
-  end   = iter_default->seq_iter;
-
-  temp_iter = g_object_new (TWEET_TYPE_STATUS_MODEL_ITER,
-                            "model", model,
-                            NULL);
-
-  while (!g_sequence_iter_is_begin (begin))
-    {
-      TWEET_STATUS_MODEL_ITER (temp_iter)->seq_iter = begin;
-      g_object_set (G_OBJECT (temp_iter), "row", row, NULL);
-
-      if (clutter_model_filter_iter (model, temp_iter))
-        {
-          end = begin;
-          break;
-        }
-
-      begin = g_sequence_iter_prev (begin);
-      row += 1;
-    }
+  if (g_sequence_get_length (priv->visible_rows) == 0)
+    return TRUE;
 
-  g_object_unref (temp_iter);
+  last = g_sequence_iter_prev (g_sequence_get_end_iter (priv->visible_rows));
+  last = g_sequence_get (last);
 
   /* This is because the 'end_iter' is always *after* the last valid iter.
-   * Otherwise we'd have endless loops 
+   * Otherwise we'd have endless loops
    */
-  end = g_sequence_iter_next (end);
-
-  return iter_default->seq_iter == end;
+  return iter_default->seq_iter == g_sequence_iter_next (last);
 }
 
 static ClutterModelIter *
 tweet_status_model_iter_next (ClutterModelIter *iter)
 {
   TweetStatusModelIter *iter_default;
-  ClutterModelIter *temp_iter;
-  ClutterModel *model = NULL;
+  ClutterModel *model;
   GSequenceIter *filter_next;
-  guint row;
 
   iter_default = TWEET_STATUS_MODEL_ITER (iter);
   g_assert (iter_default->seq_iter != NULL);
 
   model = clutter_model_iter_get_model (iter);
-  row   = clutter_model_iter_get_row (iter) + 1;
-
-  filter_next = g_sequence_iter_next (iter_default->seq_iter);
-  g_assert (filter_next != NULL);
-
-  temp_iter = g_object_new (TWEET_TYPE_STATUS_MODEL_ITER,
-                            "model", model,
-                            NULL);
-
-  while (!g_sequence_iter_is_end (filter_next))
-    {
-      TWEET_STATUS_MODEL_ITER (temp_iter)->seq_iter = filter_next;
-      g_object_set (G_OBJECT (temp_iter), "row", row, NULL);
-
-      if (clutter_model_filter_iter (model, temp_iter))
-        break;
-
-      filter_next = g_sequence_iter_next (filter_next);
-      row += 1;
-    }
-
-  g_object_unref (temp_iter);
 
-  /* We do this because the 'end_iter' is always *after* the
-   * last valid iter. Otherwise loops will go on forever
-   */
-  if (filter_next == iter_default->seq_iter)
-    filter_next = g_sequence_iter_next (filter_next);
+  filter_next = tweet_status_model_next_visible (TWEET_STATUS_MODEL (model),
+                                                 iter_default->seq_iter);
 
-  /* update the iterator and return it */
-  g_object_set (G_OBJECT (iter_default), "model", model, "row", row, NULL);
+  /* update the iterator and return it; the model does not change */
+  tweet_status_model_iter_set_row (iter_default,
+                                   g_sequence_iter_get_position (filter_next));
   iter_default->seq_iter = filter_next;
 
   return CLUTTER_MODEL_ITER (iter_default);
@@ -342,46 +498,20 @@ static ClutterModelIter *
 tweet_status_model_iter_prev (ClutterModelIter *iter)
 {
   TweetStatusModelIter *iter_default;
-  ClutterModelIter *temp_iter;
   ClutterModel *model;
   GSequenceIter *filter_prev;
-  guint row;
 
   iter_default = TWEET_STATUS_MODEL_ITER (iter);
   g_assert (iter_default->seq_iter != NULL);
 
   model = clutter_model_iter_get_model (iter);
-  row   = clutter_model_iter_get_row (iter) - 1;
-
-  filter_prev = g_sequence_iter_prev (iter_default->seq_iter);
-  g_assert (filter_prev != NULL);
-
-  temp_iter = g_object_new (TWEET_TYPE_STATUS_MODEL_ITER,
-                            "model", model,
-                            NULL);
-
-  while (!g_sequence_iter_is_begin (filter_prev))
-    {
-      TWEET_STATUS_MODEL_ITER (temp_iter)->seq_iter = filter_prev;
-      g_object_set (G_OBJECT (temp_iter), "row", row, NULL);
-
-      if (clutter_model_filter_iter (model, temp_iter))
-        break;
 
-      filter_prev = g_sequence_iter_prev (filter_prev);
-      row -= 1;
-    }
-
-  g_object_unref (temp_iter);
-
-  /* We do this because the 'end_iter' is always *after* the last
-   * valid iter. Otherwise loops will go on forever
-   */
-  if (filter_prev == iter_default->seq_iter)
-    filter_prev = g_sequence_iter_prev (filter_prev);
+  filter_prev = tweet_status_model_prev_visible (TWEET_STATUS_MODEL (model),
+                                                 iter_default->seq_iter);
 
-  /* update the iterator and return it */
-  g_object_set (G_OBJECT (iter_default), "model", model, "row", row, NULL);
+  /* update the iterator and return it; the model does not change */
+  tweet_status_model_iter_set_row (iter_default,
+                                   g_sequence_iter_get_position (filter_prev));
   iter_default->seq_iter = filter_prev;
 
   return CLUTTER_MODEL_ITER (iter_default);
@@ -415,17 +545,73 @@ tweet_status_model_iter_copy (ClutterModelIter *iter)
 }
 #endif /* CLUTTER_CHECK_VERSION(0, 7, 0) */
 
+static guint
+tweet_status_model_iter_get_row (ClutterModelIter *iter)
+{
+  return TWEET_STATUS_MODEL_ITER (iter)->row;
+}
+
+static void
+tweet_status_model_iter_set_property (GObject      *gobject,
+                                      guint         prop_id,
+                                      const GValue *value,
+                                      GParamSpec   *pspec)
+{
+  TweetStatusModelIter *iter = TWEET_STATUS_MODEL_ITER (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_ITER_ROW:
+      iter->row = g_value_get_uint (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+tweet_status_model_iter_get_property (GObject    *gobject,
+                                      guint       prop_id,
+                                      GValue     *value,
+                                      GParamSpec *pspec)
+{
+  TweetStatusModelIter *iter = TWEET_STATUS_MODEL_ITER (gobject);
+
+  switch (prop_id)
+    {
+    case PROP_ITER_ROW:
+      g_value_set_uint (value, iter->row);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
+      break;
+    }
+}
+
 static void
 tweet_status_model_iter_class_init (TweetStatusModelIterClass *klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   ClutterModelIterClass *iter_class = CLUTTER_MODEL_ITER_CLASS (klass);
 
+  /* the row is only set through the property from outside of the
+   * model, e.g. when creating an iterator
+   */
+  gobject_class->set_property = tweet_status_model_iter_set_property;
+  gobject_class->get_property = tweet_status_model_iter_get_property;
+
+  g_object_class_override_property (gobject_class, PROP_ITER_ROW, "row");
+
   iter_class->get_value = tweet_status_model_iter_get_value;
   iter_class->set_value = tweet_status_model_iter_set_value;
   iter_class->is_first  = tweet_status_model_iter_is_first;
   iter_class->is_last   = tweet_status_model_iter_is_last;
   iter_class->next      = tweet_status_model_iter_next;
   iter_class->prev      = tweet_status_model_iter_prev;
+  iter_class->get_row   = tweet_status_model_iter_get_row;
 
 #if CLUTTER_CHECK_VERSION(0, 7, 0)
   iter_class->copy      = tweet_status_model_iter_copy;
@@ -436,6 +622,7 @@ static void
 tweet_status_model_iter_init (TweetStatusModelIter *iter)
 {
   iter->seq_iter = NULL;
+  iter->row = 0;
 }
 
 /*
@@ -469,37 +656,24 @@ tweet_status_model_insert_row (ClutterModel *model,
 {
   TweetStatusModelPrivate *priv = TWEET_STATUS_MODEL (model)->priv;
   TweetStatusModelIter *retval;
-  guint n_columns, i, pos;
-  GValueArray *array;
   GSequenceIter *seq_iter;
+  guint pos;
 
-  n_columns = clutter_model_get_n_columns (model);
-  array = g_value_array_new (n_columns);
-
-  for (i = 0; i < n_columns; i++)
-    {
-      GValue *value = NULL;
-
-      g_value_array_append (array, NULL);
-
-      value = g_value_array_get_nth (array, i);
-      g_value_init (value, clutter_model_get_column_type (model, i));
-    }
-
+  /* the row is empty until the status is set */
   if (index_ < 0)
     {
-      seq_iter = g_sequence_append (priv->sequence, array);
-      pos = g_sequence_get_length (priv->sequence);
+      seq_iter = g_sequence_append (priv->sequence, NULL);
+      pos = g_sequence_get_length (priv->sequence) - 1;
     }
   else if (index_ == 0)
     {
-      seq_iter = g_sequence_prepend (priv->sequence, array);
+      seq_iter = g_sequence_prepend (priv->sequence, NULL);
       pos = 0;
     }
   else
     {
       seq_iter = g_sequence_get_iter_at_pos (priv->sequence, index_);
-      seq_iter = g_sequence_insert_before (seq_iter, array);
+      seq_iter = g_sequence_insert_before (seq_iter, NULL);
       pos = index_;
     }
 
@@ -518,41 +692,32 @@ tweet_status_model_remove_row (ClutterModel *model,
 {
   TweetStatusModelPrivate *priv = TWEET_STATUS_MODEL (model)->priv;
   GSequenceIter *seq_iter;
-  guint pos = 0;
+  ClutterModelIter *iter;
 
-  seq_iter = g_sequence_get_begin_iter (priv->sequence);
-  while (!g_sequence_iter_is_end (seq_iter))
-    {
-      if (clutter_model_filter_row (model, pos))
-        {
-          if (pos == row)
-            {  
-              ClutterModelIter *iter;
-
-              iter = g_object_new (TWEET_TYPE_STATUS_MODEL_ITER,
-                                   "model", model,
-                                   "row", pos,
-                                   NULL);
-              TWEET_STATUS_MODEL_ITER (iter)->seq_iter = seq_iter;
-
-              /* the actual row is removed from the sequence inside
-               * the ::row-removed signal class handler, so that every
-               * handler connected to ::row-removed will still get
-               * a valid iterator, and every signal connected to
-               * ::row-removed with the AFTER flag will get an updated
-               * model
-               */
-              g_signal_emit_by_name (model, "row-removed", iter);
-
-              g_object_unref (iter);
-
-              break;
-            }
-        }
+  if (row >= g_sequence_get_length (priv->sequence))
+    return;
+
+  /* only the rows passing the filter can be removed */
+  seq_iter = g_sequence_get_iter_at_pos (priv->sequence, row);
+  if (g_hash_table_lookup (priv->visible_by_row, seq_iter) == NULL)
+    return;
+
+  iter = g_object_new (TWEET_TYPE_STATUS_MODEL_ITER,
+                       "model", model,
+                       "row", row,
+                       NULL);
+  TWEET_STATUS_MODEL_ITER (iter)->seq_iter = seq_iter;
+
+  /* the actual row is removed from the sequence inside
+   * the ::row-removed signal class handler, so that every
+   * handler connected to ::row-removed will still get
+   * a valid iterator, and every signal connected to
+   * ::row-removed with the AFTER flag will get an updated
+   * model
+   */
+  g_signal_emit_by_name (model, "row-removed", iter);
 
-      pos += 1;
-      seq_iter = g_sequence_iter_next (seq_iter);
-    }
+  g_object_unref (iter);
 }
 
 static guint
@@ -576,14 +741,23 @@ sort_model_default (gconstpointer a,
                     gconstpointer b,
                     gpointer      data)
 {
-  GValueArray *row_a = (GValueArray *) a;
-  GValueArray *row_b = (GValueArray *) b;
   SortClosure *clos = data;
+  GValue value_a = { 0, };
+  GValue value_b = { 0, };
+  gint retval;
+
+  g_value_init (&value_a, TWITTER_TYPE_STATUS);
+  g_value_set_object (&value_a, (gpointer) a);
+
+  g_value_init (&value_b, TWITTER_TYPE_STATUS);
+  g_value_set_object (&value_b, (gpointer) b);
+
+  retval = clos->func (clos->model, &value_a, &value_b, clos->data);
+
+  g_value_unset (&value_a);
+  g_value_unset (&value_b);
 
-  return clos->func (clos->model,
-                     g_value_array_get_nth (row_a, clos->column),
-                     g_value_array_get_nth (row_b, clos->column),
-                     clos->data);
+  return retval;
 }
 
 static void
@@ -601,19 +775,46 @@ tweet_status_model_resort (ClutterModel         *model,
   g_sequence_sort (TWEET_STATUS_MODEL (model)->priv->sequence,
                    sort_model_default,
                    &sort_closure);
+
+  /* the rows are the same, only their order changed */
+  tweet_status_model_rebuild_visible (TWEET_STATUS_MODEL (model), FALSE);
+}
+
+static void
+tweet_status_model_filter_changed (ClutterModel *model)
+{
+  tweet_status_model_rebuild_visible (TWEET_STATUS_MODEL (model), TRUE);
 }
 
 static void
 tweet_status_model_row_removed (ClutterModel     *model,
                                 ClutterModelIter *iter)
 {
+  TweetStatusModelPrivate *priv = TWEET_STATUS_MODEL (model)->priv;
   TweetStatusModelIter *iter_default;
-  GValueArray *array;
+  GSequenceIter *visible_iter;
+  TwitterStatus *status;
 
   iter_default = TWEET_STATUS_MODEL_ITER (iter);
 
-  array = g_sequence_get (iter_default->seq_iter);
-  g_value_array_free (array);
+  status = g_sequence_get (iter_default->seq_iter);
+
+  tweet_status_model_unindex_status (TWEET_STATUS_MODEL (model),
+                                     iter_default->seq_iter,
+                                     status);
+
+  g_hash_table_remove (priv->changed_rows, iter_default->seq_iter);
+
+  visible_iter = g_hash_table_lookup (priv->visible_by_row,
+                                      iter_default->seq_iter);
+  if (visible_iter != NULL)
+    {
+      g_sequence_remove (visible_iter);
+      g_hash_table_remove (priv->visible_by_row, iter_default->seq_iter);
+    }
+
+  if (status)
+    g_object_unref (status);
 
   g_sequence_remove (iter_default->seq_iter);
   iter_default->seq_iter = NULL;
@@ -628,12 +829,30 @@ tweet_status_model_finalize (GObject *gobject)
   iter = g_sequence_get_begin_iter (priv->sequence);
   while (!g_sequence_iter_is_end (iter))
     {
-      GValueArray *value_array = g_sequence_get (iter);
+      TwitterStatus *status = g_sequence_get (iter);
+
+      tweet_status_model_unindex_status (TWEET_STATUS_MODEL (gobject), iter,
+                                         status);
+
+      if (status)
+        g_object_unref (status);
 
-      g_value_array_free (value_array);
       iter = g_sequence_iter_next (iter);
     }
   g_sequence_free (priv->sequence);
+  g_hash_table_destroy (priv->status_by_id);
+  g_hash_table_destroy (priv->changed_rows);
+  g_sequence_free (priv->visible_rows);
+  g_hash_table_destroy (priv->visible_by_row);
+
+  if (priv->filter_iter)
+    g_object_unref (priv->filter_iter);
+
+  if (priv->changed_id)
+    g_source_remove (priv->changed_id);
+
+  if (priv->expire_id)
+    g_source_remove (priv->expire_id);
 
   G_OBJECT_CLASS (tweet_status_model_parent_class)->finalize (gobject);
 }
@@ -655,6 +874,24 @@ tweet_status_model_class_init (TweetStatusModelClass *klass)
   model_class->resort          = tweet_status_model_resort;
 
   model_class->row_removed     = tweet_status_model_row_removed;
+  model_class->filter_changed  = tweet_status_model_filter_changed;
+
+  /**
+   * TweetStatusModel::rows-changed:
+   * @model: the model that received the signal
+   *
+   * The ::rows-changed signal is emitted at most once per frame,
+   * after the ::row-changed signal has been emitted for every row
+   * whose status changed since the previous frame.
+   */
+  model_signals[ROWS_CHANGED] =
+    g_signal_new (g_intern_static_string ("rows-changed"),
+                  G_TYPE_FROM_CLASS (gobject_class),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (TweetStatusModelClass, rows_changed),
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE, 0);
 }
 
 static void
@@ -669,6 +906,10 @@ tweet_status_model_init (TweetStatusModel *model)
   model->priv = priv = TWEET_STATUS_MODEL_GET_PRIVATE (model);
 
   priv->sequence = g_sequence_new (NULL);
+  priv->status_by_id = g_hash_table_new (NULL, NULL);
+  priv->changed_rows = g_hash_table_new (NULL, NULL);
+  priv->visible_rows = g_sequence_new (NULL);
+  priv->visible_by_row = g_hash_table_new (NULL, NULL);
 
   clutter_model_set_types (base_model, model_columns, model_types);
   clutter_model_set_names (base_model, model_columns, model_names);
@@ -680,69 +921,202 @@ tweet_status_model_new (void)
   return g_object_new (TWEET_TYPE_STATUS_MODEL, NULL);
 }
 
+static ClutterModelIter *
+tweet_status_model_get_iter_for_seq (TweetStatusModel *model,
+                                     GSequenceIter    *seq_iter)
+{
+  TweetStatusModelIter *retval;
+
+  retval = g_object_new (TWEET_TYPE_STATUS_MODEL_ITER,
+                         "model", model,
+                         "row", g_sequence_iter_get_position (seq_iter),
+                         NULL);
+  retval->seq_iter = seq_iter;
+
+  return CLUTTER_MODEL_ITER (retval);
+}
+
 static void
-status_changed_cb (TwitterStatus    *status,
-                   TweetStatusModel *model)
+emit_row_changed (TweetStatusModel *model,
+                  GSequenceIter    *seq_iter)
 {
   ClutterModelIter *iter;
 
-  iter = clutter_model_get_first_iter (CLUTTER_MODEL (model));
-  while (!clutter_model_iter_is_last (iter))
-    {
-      TwitterStatus *iter_status;
-      guint iter_status_id, status_id;
+  /* the handlers of ::row-changed must see the new visibility, so
+   * the row is filtered again before the emission; the rows set
+   * through an iterator are filtered when their value is set
+   */
+  tweet_status_model_update_visible (model, seq_iter);
 
-      clutter_model_iter_get (iter, 0, &iter_status, -1);
-      if (!iter_status)
-        {
-          clutter_model_iter_next (iter);
-          continue;
-        }
+  iter = tweet_status_model_get_iter_for_seq (model, seq_iter);
+  g_signal_emit_by_name (model, "row-changed", iter);
+  g_object_unref (iter);
+}
+
+static void
+collect_changed_id (gpointer key,
+                    gpointer value,
+                    gpointer data)
+{
+  TwitterStatus *status = g_sequence_get (key);
+  GArray *changed_ids = data;
+  guint status_id;
+
+  if (!status)
+    return;
+
+  status_id = twitter_status_get_id (status);
+  g_array_append_val (changed_ids, status_id);
+}
+
+static gboolean
+emit_rows_changed (gpointer data)
+{
+  TweetStatusModel *model = data;
+  TweetStatusModelPrivate *priv = model->priv;
+  GArray *changed_ids;
+  guint i;
 
-      iter_status_id = twitter_status_get_id (iter_status);
-      status_id = twitter_status_get_id (status);
+  priv->changed_id = 0;
 
-      if (iter_status == status || iter_status_id == status_id)
-        g_signal_emit_by_name (model, "row-changed", iter);
+  /* a ::row-changed handler might remove rows, so we keep the ids
+   * of the changed statuses and look the rows up again before each
+   * emission; the statuses changed by the handlers will be notified
+   * on the next frame
+   */
+  changed_ids = g_array_sized_new (FALSE, FALSE, sizeof (guint),
+                                   g_hash_table_size (priv->changed_rows));
+  g_hash_table_foreach (priv->changed_rows, collect_changed_id, changed_ids);
+  g_hash_table_remove_all (priv->changed_rows);
 
-      g_object_unref (iter_status);
+  for (i = 0; i < changed_ids->len; i++)
+    {
+      guint status_id = g_array_index (changed_ids, guint, i);
+      GSequenceIter *seq_iter;
 
-      clutter_model_iter_next (iter);
+      seq_iter = g_hash_table_lookup (priv->status_by_id,
+                                      GUINT_TO_POINTER (status_id));
+      if (seq_iter)
+        emit_row_changed (model, seq_iter);
     }
 
+  g_array_free (changed_ids, TRUE);
+
+  g_signal_emit (model, model_signals[ROWS_CHANGED], 0);
+
+  return FALSE;
+}
+
+/* the statuses change every time one of their users changes, e.g.
+ * when an avatar is loaded, so we queue the changed rows and notify
+ * them once per frame
+ */
+static void
+status_changed_cb (TwitterStatus    *status,
+                   TweetStatusModel *model)
+{
+  TweetStatusModelPrivate *priv = model->priv;
+  GSequenceIter *seq_iter;
+
+  seq_iter = g_hash_table_lookup (priv->status_by_id,
+                                  GUINT_TO_POINTER (twitter_status_get_id (status)));
+  if (!seq_iter)
+    return;
+
+  g_hash_table_insert (priv->changed_rows, seq_iter, seq_iter);
+
+  /* run before the stage is redrawn */
+  if (!priv->changed_id)
+    priv->changed_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                        emit_rows_changed,
+                                        model,
+                                        NULL);
+}
+
+static void
+tweet_status_model_remove_seq (TweetStatusModel *model,
+                               GSequenceIter    *seq_iter)
+{
+  ClutterModelIter *iter;
+
+  /* see tweet_status_model_remove_row() */
+  iter = tweet_status_model_get_iter_for_seq (model, seq_iter);
+  g_signal_emit_by_name (model, "row-removed", iter);
   g_object_unref (iter);
 }
 
 static gboolean
-tweet_status_model_lookup_status (TweetStatusModel *model,
-                                  TwitterStatus    *status)
+status_is_expired (TwitterStatus *status,
+                   glong          cutoff)
 {
-  ClutterModelIter *iter;
-  gboolean retval = FALSE;
+  const gchar *created_at;
+  GTimeVal timeval = { 0, };
 
-  iter = clutter_model_get_first_iter (CLUTTER_MODEL (model));
-  if (!iter)
+  created_at = twitter_status_get_created_at (status);
+  if (!created_at || !twitter_date_to_time_val (created_at, &timeval))
     return FALSE;
 
-  while (!clutter_model_iter_is_last (iter))
-    {
-      TwitterStatus *s;
+  return timeval.tv_sec < cutoff;
+}
+
+/* removes the rows from the end of the model until it respects the
+ * size and age limits; the rows removed release their statuses
+ */
+static void
+tweet_status_model_enforce_limits (TweetStatusModel *model)
+{
+  TweetStatusModelPrivate *priv = model->priv;
+  GSequenceIter *seq_iter;
 
-      clutter_model_iter_get (iter, 0, &s, -1);
-      if (twitter_status_get_id (s) == twitter_status_get_id (status))
+  if (priv->max_size > 0)
+    {
+      while (g_sequence_get_length (priv->sequence) > priv->max_size)
         {
-          retval = TRUE;
-          g_object_unref (s);
-          break;
+          seq_iter = g_sequence_get_end_iter (priv->sequence);
+          seq_iter = g_sequence_iter_prev (seq_iter);
+
+          tweet_status_model_remove_seq (model, seq_iter);
         }
+    }
+
+  if (priv->max_age > 0)
+    {
+      GTimeVal now;
 
-      g_object_unref (s);
-      clutter_model_iter_next (iter);
+      g_get_current_time (&now);
+
+      while (g_sequence_get_length (priv->sequence) > 0)
+        {
+          TwitterStatus *status;
+
+          seq_iter = g_sequence_get_end_iter (priv->sequence);
+          seq_iter = g_sequence_iter_prev (seq_iter);
+
+          status = g_sequence_get (seq_iter);
+          if (status && !status_is_expired (status, now.tv_sec - priv->max_age))
+            break;
+
+          tweet_status_model_remove_seq (model, seq_iter);
+        }
     }
+}
 
-  g_object_unref (iter);
+static gboolean
+expire_timeout (gpointer data)
+{
+  tweet_status_model_enforce_limits (data);
 
-  return retval;
+  return TRUE;
+}
+
+static inline gboolean
+tweet_status_model_lookup_status (TweetStatusModel *model,
+                                  TwitterStatus    *status)
+{
+  guint status_id = twitter_status_get_id (status);
+
+  return g_hash_table_lookup (model->priv->status_by_id,
+                              GUINT_TO_POINTER (status_id)) != NULL;
 }
 
 gboolean
@@ -756,11 +1130,10 @@ tweet_status_model_append_status (TweetStatusModel *model,
     return FALSE;
 
   clutter_model_append (CLUTTER_MODEL (model), 0, status, -1);
-  g_signal_connect (status, "changed",
-                    G_CALLBACK (status_changed_cb),
-                    model);
+  tweet_status_model_enforce_limits (model);
 
-  return TRUE;
+  /* the status might have been removed right away by the limits */
+  return tweet_status_model_lookup_status (model, status);
 }
 
 gboolean
@@ -774,9 +1147,44 @@ tweet_status_model_prepend_status (TweetStatusModel *model,
     return FALSE;
 
   clutter_model_prepend (CLUTTER_MODEL (model), 0, status, -1);
-  g_signal_connect (status, "changed",
-                    G_CALLBACK (status_changed_cb),
-                    model);
+  tweet_status_model_enforce_limits (model);
+
+  return tweet_status_model_lookup_status (model, status);
+}
+
+gboolean
+tweet_status_model_insert_status (TweetStatusModel *model,
+                                  TwitterStatus    *status,
+                                  guint             position)
+{
+  g_return_val_if_fail (TWEET_IS_STATUS_MODEL (model), FALSE);
+  g_return_val_if_fail (TWITTER_IS_STATUS (status), FALSE);
+
+  if (tweet_status_model_lookup_status (model, status))
+    return FALSE;
+
+  position = MIN (position, g_sequence_get_length (model->priv->sequence));
+
+  clutter_model_insert (CLUTTER_MODEL (model), position, 0, status, -1);
+  tweet_status_model_enforce_limits (model);
+
+  return tweet_status_model_lookup_status (model, status);
+}
+
+gboolean
+tweet_status_model_remove_status (TweetStatusModel *model,
+                                  guint             status_id)
+{
+  GSequenceIter *seq_iter;
+
+  g_return_val_if_fail (TWEET_IS_STATUS_MODEL (model), FALSE);
+
+  seq_iter = g_hash_table_lookup (model->priv->status_by_id,
+                                  GUINT_TO_POINTER (status_id));
+  if (!seq_iter)
+    return FALSE;
+
+  tweet_status_model_remove_seq (model, seq_iter);
 
   return TRUE;
 }
@@ -790,8 +1198,10 @@ tweet_status_model_get_status (TweetStatusModel *model,
   g_return_val_if_fail (TWEET_IS_STATUS_MODEL (model), NULL);
   g_return_val_if_fail (TWEET_IS_STATUS_MODEL_ITER (iter), NULL);
 
-  status = NULL;
-  clutter_model_iter_get (iter, 0, &status, -1);
+  /* the rows hold the statuses directly, so we can skip the GValue */
+  status = g_sequence_get (TWEET_STATUS_MODEL_ITER (iter)->seq_iter);
+  if (status)
+    g_object_ref (status);
 
   return status;
 }
@@ -808,5 +1218,50 @@ tweet_status_model_set_max_size (TweetStatusModel *model,
   if (priv->max_size != max_size)
     {
       priv->max_size = max_size;
+
+      tweet_status_model_enforce_limits (model);
+    }
+}
+
+gint
+tweet_status_model_get_max_size (TweetStatusModel *model)
+{
+  g_return_val_if_fail (TWEET_IS_STATUS_MODEL (model), 0);
+
+  return model->priv->max_size;
+}
+
+void
+tweet_status_model_set_max_age (TweetStatusModel *model,
+                                gint              max_age)
+{
+  TweetStatusModelPrivate *priv;
+
+  g_return_if_fail (TWEET_IS_STATUS_MODEL (model));
+
+  priv = model->priv;
+  if (priv->max_age != max_age)
+    {
+      priv->max_age = max_age;
+
+      if (priv->max_age > 0 && !priv->expire_id)
+        priv->expire_id = g_timeout_add_seconds (EXPIRE_INTERVAL,
+                                                 expire_timeout,
+                                                 model);
+      else if (priv->max_age <= 0 && priv->expire_id)
+        {
+          g_source_remove (priv->expire_id);
+          priv->expire_id = 0;
+        }
+
+      tweet_status_model_enforce_limits (model);
     }
 }
+
+gint
+tweet_status_model_get_max_age (TweetStatusModel *model)
+{
+  g_return_val_if_fail (TWEET_IS_STATUS_MODEL (model), 0);
+
+  return model->priv->max_age;
+}
@@ -45,6 +45,8 @@ struct _TweetStatusModel
 struct _TweetStatusModelClass
 {
   ClutterModelClass parent_class;
+
+  void (* rows_changed) (TweetStatusModel *model);
 };
 
 GType tweet_status_model_get_type (void);
@@ -54,10 +56,22 @@ gboolean       tweet_status_model_append_status  (TweetStatusModel *model,
                                                   TwitterStatus    *status);
 gboolean       tweet_status_model_prepend_status (TweetStatusModel *model,
                                                   TwitterStatus    *status);
+gboolean       tweet_status_model_insert_status  (TweetStatusModel *model,
+                                                  TwitterStatus    *status,
+                                                  guint             position);
+gboolean       tweet_status_model_remove_status  (TweetStatusModel *model,
+                                                  guint             status_id);
 
 TwitterStatus *tweet_status_model_get_status     (TweetStatusModel *model,
                                                   ClutterModelIter *iter);
 
+void           tweet_status_model_set_max_size   (TweetStatusModel *model,
+                                                  gint              max_size);
+gint           tweet_status_model_get_max_size   (TweetStatusModel *model);
+void           tweet_status_model_set_max_age    (TweetStatusModel *model,
+                                                  gint              max_age);
+gint           tweet_status_model_get_max_age    (TweetStatusModel *model);
+
 G_END_DECLS
 
 #endif /* __TWEET_STATUS_MODEL_H__ */
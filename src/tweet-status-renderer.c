@@ -83,7 +83,9 @@ tweet_status_renderer_get_cell_actor (TidyCellRenderer *renderer,
   if (G_VALUE_TYPE (value) != TWITTER_TYPE_STATUS)
     return NULL;
   else
-    retval = tweet_status_cell_new (g_value_get_object (value), font_name);
+    retval = tweet_status_cell_new (g_value_get_object (value),
+                                    font_name,
+                                    size ? size->width : -1);
 
 out:
   g_free (font_name);
@@ -94,12 +96,142 @@ out:
   return retval;
 }
 
+static ClutterUnit
+tweet_status_renderer_get_cell_height (TidyCellRenderer *renderer,
+                                       TidyActor        *list_view,
+                                       const GValue     *value,
+                                       TidyCellState     cell_state,
+                                       ClutterUnit       width,
+                                       gint              row,
+                                       gint              column)
+{
+  TweetStatusRenderer *status_renderer = TWEET_STATUS_RENDERER (renderer);
+  ClutterUnit retval;
+  gchar *font_name;
+
+  /* the headers are never measured, so we let the default
+   * implementation deal with them
+   */
+  if (row == -1 || cell_state == TIDY_CELL_HEADER)
+    {
+      TidyCellRendererClass *parent_class;
+
+      parent_class =
+        TIDY_CELL_RENDERER_CLASS (tweet_status_renderer_parent_class);
+
+      return parent_class->get_cell_height (renderer, list_view,
+                                            value,
+                                            cell_state,
+                                            width,
+                                            row, column);
+    }
+
+  if (G_VALUE_TYPE (value) != TWITTER_TYPE_STATUS)
+    return 0;
+
+  if (G_UNLIKELY (status_renderer->measure_label == NULL))
+    {
+      status_renderer->measure_label = g_object_ref_sink (clutter_label_new ());
+      status_renderer->escape_re = g_regex_new ("&(?!(amp|gt|lt|apos))",
+                                                0, 0,
+                                                NULL);
+    }
+
+  tidy_stylable_get (TIDY_STYLABLE (list_view), "font-name", &font_name, NULL);
+
+  retval = tweet_status_cell_get_height_for_status (g_value_get_object (value),
+                                                    font_name,
+                                                    CLUTTER_UNITS_TO_DEVICE (width),
+                                                    status_renderer->measure_label,
+                                                    status_renderer->escape_re);
+
+  g_free (font_name);
+
+  return retval;
+}
+
+static gboolean
+tweet_status_renderer_update_cell_actor (TidyCellRenderer *renderer,
+                                         TidyActor        *list_view,
+                                         ClutterActor     *cell,
+                                         const GValue     *value,
+                                         TidyCellState     cell_state,
+                                         ClutterGeometry  *size,
+                                         gint              row,
+                                         gint              column)
+{
+  gchar *font_name;
+  gboolean retval;
+
+  if (row == -1 || cell_state == TIDY_CELL_HEADER)
+    return FALSE;
+
+  if (G_VALUE_TYPE (value) != TWITTER_TYPE_STATUS ||
+      !TWEET_IS_STATUS_CELL (cell))
+    return FALSE;
+
+  tidy_stylable_get (TIDY_STYLABLE (list_view), "font-name", &font_name, NULL);
+
+  /* the font and the width are set at construction time */
+  retval = (g_strcmp0 (font_name, TWEET_STATUS_CELL (cell)->font_name) == 0 &&
+            (!size || size->width == TWEET_STATUS_CELL (cell)->width));
+  if (retval)
+    tweet_status_cell_set_status (TWEET_STATUS_CELL (cell),
+                                  g_value_get_object (value));
+
+  g_free (font_name);
+
+  return retval;
+}
+
+static void
+tweet_status_renderer_release_cell_actor (TidyCellRenderer *renderer,
+                                          TidyActor        *list_view,
+                                          ClutterActor     *cell)
+{
+  TwitterStatus *status;
+
+  if (!TWEET_IS_STATUS_CELL (cell))
+    return;
+
+  /* an unused cell should not keep the profile image of its user
+   * among the urgent downloads
+   */
+  status = TWEET_STATUS_CELL (cell)->status;
+  if (status)
+    twitter_user_release_profile_image (twitter_status_get_user (status),
+                                        G_OBJECT (cell));
+}
+
+static void
+tweet_status_renderer_finalize (GObject *gobject)
+{
+  TweetStatusRenderer *renderer = TWEET_STATUS_RENDERER (gobject);
+
+  if (renderer->measure_label)
+    {
+      clutter_actor_destroy (renderer->measure_label);
+      g_object_unref (renderer->measure_label);
+    }
+
+  if (renderer->escape_re)
+    g_regex_unref (renderer->escape_re);
+
+  G_OBJECT_CLASS (tweet_status_renderer_parent_class)->finalize (gobject);
+}
+
 static void
 tweet_status_renderer_class_init (TweetStatusRendererClass *klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   TidyCellRendererClass *renderer_class = TIDY_CELL_RENDERER_CLASS (klass);
 
+  gobject_class->finalize = tweet_status_renderer_finalize;
+
   renderer_class->get_cell_actor = tweet_status_renderer_get_cell_actor;
+  renderer_class->get_cell_height = tweet_status_renderer_get_cell_height;
+  renderer_class->update_cell_actor = tweet_status_renderer_update_cell_actor;
+  renderer_class->release_cell_actor = tweet_status_renderer_release_cell_actor;
 }
 
 static void
@@ -38,6 +38,10 @@ typedef struct _TweetStatusRendererClass        TweetStatusRendererClass;
 struct _TweetStatusRenderer
 {
   TidyCellRenderer parent_instance;
+
+  /* used to measure the rows without creating their cells */
+  ClutterActor *measure_label;
+  GRegex *escape_re;
 };
 
 struct _TweetStatusRendererClass
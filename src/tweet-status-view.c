@@ -80,6 +80,9 @@ tweet_status_view_init (TweetStatusView *view)
   tidy_list_view_set_rules_hint (TIDY_LIST_VIEW (view), FALSE);
   tidy_list_view_set_show_headers (TIDY_LIST_VIEW (view), FALSE);
 
+  /* only the statuses on screen have a cell */
+  tidy_list_view_set_virtualized (TIDY_LIST_VIEW (view), TRUE);
+
   tidy_stylable_set (TIDY_STYLABLE (view),
                      "v-padding", 6,
                      NULL);
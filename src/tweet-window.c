@@ -95,10 +95,22 @@ struct _TweetWindowPrivate
   TwitterClient *client;
   TwitterUser *user;
 
-  gint n_status_received;
-
   GTimeVal last_update;
 
+  /* the newest status received by the current view; the view is
+   * rebuilt every time it changes, so we only need one
+   */
+  guint last_status_id;
+
+  /* position of the next status received while streaming, and the
+   * first status streamed by the current timeline request
+   */
+  guint n_streamed;
+  guint first_streamed_id;
+
+  /* the timeline request for the current view, if any */
+  guint timeline_request;
+
   TweetConfig *config;
   TweetStatusModel *status_model;
 
@@ -254,6 +266,52 @@ tweet_window_status_message (TweetWindow     *window,
     gtk_status_icon_set_visible (priv->status_icon, TRUE);
 }
 
+static void
+tweet_window_stop_spinner (TweetWindow *window)
+{
+  TweetWindowPrivate *priv = window->priv;
+  TweetAnimation *animation;
+
+  tweet_spinner_stop (TWEET_SPINNER (priv->spinner));
+  animation =
+    tweet_actor_animate (priv->spinner, TWEET_LINEAR, 500,
+                         "opacity", tweet_interval_new (G_TYPE_UCHAR, 127, 0),
+                         NULL);
+  g_signal_connect_swapped (animation,
+                            "completed", G_CALLBACK (clutter_actor_hide),
+                            priv->spinner);
+}
+
+static TweetStatusModel *
+tweet_window_create_model (TweetWindow *window)
+{
+  TweetWindowPrivate *priv = window->priv;
+  TweetStatusModel *model;
+
+  model = TWEET_STATUS_MODEL (tweet_status_model_new ());
+
+  /* the model does not grow without bounds */
+  tweet_status_model_set_max_size (model,
+                                   tweet_config_get_max_statuses (priv->config));
+  tweet_status_model_set_max_age (model,
+                                  tweet_config_get_max_status_age (priv->config));
+
+  return model;
+}
+
+static void
+tweet_window_ensure_model (TweetWindow *window)
+{
+  TweetWindowPrivate *priv = window->priv;
+
+  if (!priv->status_model)
+    {
+      priv->status_model = tweet_window_create_model (window);
+      tidy_list_view_set_model (TIDY_LIST_VIEW (priv->status_view),
+                                CLUTTER_MODEL (priv->status_model));
+    }
+}
+
 static void
 on_status_received (TwitterClient *client,
                     TwitterStatus *status,
@@ -261,20 +319,67 @@ on_status_received (TwitterClient *client,
                     TweetWindow   *window)
 {
   TweetWindowPrivate *priv = window->priv;
+  guint status_id;
 
   if (error)
     {
-      TweetAnimation *animation;
+      tweet_window_status_message (window, TWEET_STATUS_ERROR,
+                                   _("Unable to retrieve status from Twitter: %s"),
+                                   error->message);
+      return;
+    }
 
-      tweet_spinner_stop (TWEET_SPINNER (priv->spinner));
-      animation =
-        tweet_actor_animate (priv->spinner, TWEET_LINEAR, 500,
-                             "opacity", tweet_interval_new (G_TYPE_UCHAR, 127, 0),
-                             NULL);
-      g_signal_connect_swapped (animation,
-                                "completed", G_CALLBACK (clutter_actor_hide),
-                                priv->spinner);
+  tweet_window_ensure_model (window);
+
+  status_id = twitter_status_get_id (status);
+
+  /* the statuses we post, or any status received outside of a
+   * timeline, are the newest ones, so they go at the top; since the
+   * timelines are streamed from the newest status to the oldest, a
+   * status newer than the first one streamed is not part of the
+   * stream either
+   */
+  if (!priv->timeline_request ||
+      (priv->n_streamed > 0 && status_id > priv->first_streamed_id))
+    {
+      /* the streamed statuses are below this one */
+      if (tweet_status_model_prepend_status (priv->status_model, status) &&
+          priv->timeline_request)
+        priv->n_streamed += 1;
 
+      return;
+    }
+
+  /* each streamed status goes below the previous one, but above the
+   * statuses we already had
+   */
+  if (tweet_status_model_insert_status (priv->status_model, status,
+                                        priv->n_streamed))
+    {
+      if (priv->n_streamed == 0)
+        priv->first_streamed_id = status_id;
+
+      priv->n_streamed += 1;
+    }
+}
+
+static void
+on_timeline_received (TwitterClient   *client,
+                      TwitterTimeline *timeline,
+                      const GError    *error,
+                      TweetWindow     *window)
+{
+  TweetWindowPrivate *priv = window->priv;
+
+  /* we handle the whole timeline at once, so we don't need
+   * the per-status emission of the default handler
+   */
+  g_signal_stop_emission_by_name (client, "timeline-received");
+
+  tweet_window_stop_spinner (window);
+
+  if (error)
+    {
       /* if the content was not modified since the last update,
        * silently ignore the error; Twitter-GLib still emits it
        * so that clients can notify the user anyway
@@ -288,56 +393,48 @@ on_status_received (TwitterClient *client,
         tweet_window_status_message (window, TWEET_STATUS_ERROR,
                                      _("Unable to retrieve status from Twitter: %s"),
                                      error->message);
-
-      priv->n_status_received = 0;
     }
   else
     {
-      if (!priv->status_model)
+      GList *statuses, *l;
+      gint n_status_received = priv->n_streamed;
+
+      tweet_window_ensure_model (window);
+
+      /* the timeline is sorted from the oldest status to the newest */
+      statuses = twitter_timeline_get_all (timeline);
+      for (l = statuses; l != NULL; l = l->next)
         {
-          priv->status_model = TWEET_STATUS_MODEL (tweet_status_model_new ());
-          tidy_list_view_set_model (TIDY_LIST_VIEW (priv->status_view),
-                                    CLUTTER_MODEL (priv->status_model));
-        }
+          guint status_id = twitter_status_get_id (l->data);
 
-      if (tweet_status_model_prepend_status (priv->status_model, status));
-        priv->n_status_received += 1;
-    }
-}
+          if (tweet_status_model_prepend_status (priv->status_model, l->data))
+            n_status_received += 1;
 
-static void
-on_timeline_complete (TwitterClient *client,
-                      TweetWindow   *window)
-{
-  TweetWindowPrivate *priv = window->priv;
-  TweetAnimation *animation;
+          if (status_id > priv->last_status_id)
+            priv->last_status_id = status_id;
+        }
 
-  tweet_spinner_stop (TWEET_SPINNER (priv->spinner));
-  animation =
-    tweet_actor_animate (priv->spinner, TWEET_LINEAR, 500,
-                         "opacity", tweet_interval_new (G_TYPE_UCHAR, 127, 0),
-                         NULL);
-  g_signal_connect_swapped (animation,
-                            "completed", G_CALLBACK (clutter_actor_hide),
-                            priv->spinner);
+      g_list_free (statuses);
 
-  if (priv->n_status_received > 0)
-    {
-      gchar *msg;
+      if (n_status_received > 0)
+        {
+          gchar *msg;
 
-      msg = g_strdup_printf (ngettext ("Received a new status",
-                                       "Received %d new statuses",
-                                       priv->n_status_received),
-                             priv->n_status_received);
+          msg = g_strdup_printf (ngettext ("Received a new status",
+                                           "Received %d new statuses",
+                                           n_status_received),
+                                 n_status_received);
 
-      tweet_window_status_message (window, TWEET_STATUS_RECEIVED, msg);
+          tweet_window_status_message (window, TWEET_STATUS_RECEIVED, msg);
 
-      g_free (msg);
-    }
+          g_free (msg);
+        }
 
-  priv->n_status_received = 0;
+      g_get_current_time (&priv->last_update);
+    }
 
-  g_get_current_time (&priv->last_update);
+  priv->n_streamed = 0;
+  priv->timeline_request = 0;
 }
 
 static void
@@ -698,6 +795,13 @@ tweet_window_clear (TweetWindow *window)
 {
   TweetWindowPrivate *priv = window->priv;
 
+  /* the statuses of the previous view should not end up in the new one */
+  if (priv->timeline_request)
+    {
+      twitter_client_cancel_request (priv->client, priv->timeline_request);
+      priv->timeline_request = 0;
+    }
+
   tidy_list_view_set_model (TIDY_LIST_VIEW (priv->status_view), NULL);
   g_object_unref (priv->status_model);
   priv->status_model = NULL;
@@ -714,6 +818,8 @@ tweet_window_refresh (TweetWindow *window)
                        "opacity", tweet_interval_new (G_TYPE_UCHAR, 0, 127),
                        NULL);
 
+  priv->n_streamed = 0;
+
   /* check for the user */
   if (!priv->user)
     twitter_client_show_user_from_email (priv->client,
@@ -722,25 +828,31 @@ tweet_window_refresh (TweetWindow *window)
   switch (priv->mode)
     {
     case TWEET_WINDOW_RECENT:
-      priv->n_status_received = 0;
-      twitter_client_get_friends_timeline (priv->client,
-                                           NULL,
-                                           priv->last_update.tv_sec);
+      /* only ask for the statuses newer than the ones we have */
+      priv->timeline_request =
+        twitter_client_get_friends_timeline_range (priv->client,
+                                                   NULL,
+                                                   priv->last_status_id,
+                                                   0);
       break;
 
     case TWEET_WINDOW_REPLIES:
-      twitter_client_get_replies (priv->client);
+      priv->timeline_request =
+        twitter_client_get_replies (priv->client);
       break;
 
     case TWEET_WINDOW_ARCHIVE:
-      twitter_client_get_user_timeline (priv->client,
-                                        NULL,
-                                        0,
-                                        priv->last_update.tv_sec);
+      priv->timeline_request =
+        twitter_client_get_user_timeline_range (priv->client,
+                                                NULL,
+                                                0,
+                                                priv->last_status_id,
+                                                0);
       break;
 
     case TWEET_WINDOW_FAVORITES:
-      twitter_client_get_favorites (priv->client, NULL, 0);
+      priv->timeline_request =
+        twitter_client_get_favorites (priv->client, NULL, 0);
       break;
     }
 
@@ -892,7 +1004,8 @@ tweet_window_constructed (GObject *gobject)
       email_address = tweet_config_get_username (priv->config);
       twitter_client_show_user_from_email (priv->client, email_address);
 
-      twitter_client_get_friends_timeline (priv->client, NULL, 0);
+      priv->timeline_request =
+        twitter_client_get_friends_timeline (priv->client, NULL, 0);
 
       refresh_time = tweet_config_get_refresh_time (priv->config);
       if (refresh_time > 0)
@@ -934,7 +1047,8 @@ tweet_window_constructed (GObject *gobject)
     email_address = tweet_config_get_username (priv->config);
     twitter_client_show_user_from_email (priv->client, email_address);
 
-    twitter_client_get_friends_timeline (priv->client, NULL, 0);
+    priv->timeline_request =
+      twitter_client_get_friends_timeline (priv->client, NULL, 0);
 
     refresh_time = tweet_config_get_refresh_time (priv->config);
     if (refresh_time > 0)
@@ -1021,6 +1135,7 @@ tweet_window_cmd_view_recent (GtkAction   *action,
 
   window->priv->mode = TWEET_WINDOW_RECENT;
   window->priv->last_update.tv_sec = 0;
+  window->priv->last_status_id = 0;
 
   tweet_window_clear (window);
   tweet_window_refresh (window);
@@ -1035,6 +1150,7 @@ tweet_window_cmd_view_replies (GtkAction   *action,
 
   window->priv->mode = TWEET_WINDOW_REPLIES;
   window->priv->last_update.tv_sec = 0;
+  window->priv->last_status_id = 0;
 
   tweet_window_clear (window);
   tweet_window_refresh (window);
@@ -1049,6 +1165,7 @@ tweet_window_cmd_view_archive (GtkAction   *action,
 
   window->priv->mode = TWEET_WINDOW_ARCHIVE;
   window->priv->last_update.tv_sec = 0;
+  window->priv->last_status_id = 0;
 
   tweet_window_clear (window);
   tweet_window_refresh (window);
@@ -1063,6 +1180,7 @@ tweet_window_cmd_view_favorites (GtkAction   *action,
 
   window->priv->mode = TWEET_WINDOW_FAVORITES;
   window->priv->last_update.tv_sec = 0;
+  window->priv->last_status_id = 0;
 
   tweet_window_clear (window);
   tweet_window_refresh (window);
@@ -1283,19 +1401,24 @@ tweet_window_init (TweetWindow *window)
 
   priv->mode = TWEET_WINDOW_RECENT;
 
-  priv->status_model = TWEET_STATUS_MODEL (tweet_status_model_new ());
-
   priv->config = tweet_config_get_default ();
+
+  priv->status_model = tweet_window_create_model (window);
+
+  /* the largest profile images are the ones in the status info */
+  twitter_user_set_profile_image_size (64);
+
   priv->client = g_object_new (TWITTER_TYPE_CLIENT,
                                "email", tweet_config_get_username (priv->config),
                                "password", tweet_config_get_password (priv->config),
                                "user-agent", "Tweet",
+                               "streaming", TRUE,
                                NULL);
   g_signal_connect (priv->client,
                     "status-received", G_CALLBACK (on_status_received),
                     window);
   g_signal_connect (priv->client,
-                    "timeline-complete", G_CALLBACK (on_timeline_complete),
+                    "timeline-received", G_CALLBACK (on_timeline_received),
                     window);
 
   priv->vbox = gtk_vbox_new (FALSE, 0);
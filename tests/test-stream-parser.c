@@ -0,0 +1,226 @@
+#include <string.h>
+#include <glib.h>
+#include <json-glib/json-glib.h>
+#include <twitter-glib/twitter-stream-parser.h>
+
+static void
+collect_element (JsonNode *element,
+                 gpointer  data)
+{
+  GPtrArray *elements = data;
+
+  /* the element is owned by the parser */
+  g_ptr_array_add (elements, json_node_copy (element));
+}
+
+static void
+free_elements (GPtrArray *elements)
+{
+  g_ptr_array_foreach (elements, (GFunc) json_node_free, NULL);
+  g_ptr_array_free (elements, TRUE);
+}
+
+/* feeds @data to a new parser, @chunk_size bytes at a time, and
+ * finishes the parsing; the elements are added to @elements
+ */
+static gboolean
+parse_in_chunks (const gchar  *data,
+                 gsize         chunk_size,
+                 GPtrArray    *elements,
+                 GError      **error)
+{
+  TwitterStreamParser *parser;
+  gsize length = strlen (data);
+  gsize offset;
+  gboolean retval = TRUE;
+
+  parser = twitter_stream_parser_new (collect_element, elements);
+
+  for (offset = 0; offset < length && retval; offset += chunk_size)
+    retval = twitter_stream_parser_feed (parser,
+                                         data + offset,
+                                         MIN (chunk_size, length - offset),
+                                         error);
+
+  if (retval)
+    retval = twitter_stream_parser_finish (parser, error);
+
+  twitter_stream_parser_free (parser);
+
+  return retval;
+}
+
+static gint64
+get_object_id (JsonNode *node)
+{
+  JsonNode *member;
+
+  g_assert (JSON_NODE_TYPE (node) == JSON_NODE_OBJECT);
+
+  member = json_object_get_member (json_node_get_object (node), "id");
+  g_assert (member != NULL);
+
+  return json_node_get_int (member);
+}
+
+static void
+test_split_chunks (void)
+{
+  const gchar *data =
+    " [ {\"id\": 1, \"text\": \"first\"},\n"
+    "   {\"id\": 2, \"user\": {\"id\": 20, \"tags\": [1, 2]}},\n"
+    "   {\"id\": 3} ]\n";
+  gsize chunk_size;
+
+  /* every possible split point must give the same result */
+  for (chunk_size = 1; chunk_size <= strlen (data); chunk_size++)
+    {
+      GPtrArray *elements = g_ptr_array_new ();
+      GError *error = NULL;
+
+      g_assert (parse_in_chunks (data, chunk_size, elements, &error));
+      g_assert (error == NULL);
+
+      g_assert_cmpuint (elements->len, ==, 3);
+      g_assert_cmpint (get_object_id (elements->pdata[0]), ==, 1);
+      g_assert_cmpint (get_object_id (elements->pdata[1]), ==, 2);
+      g_assert_cmpint (get_object_id (elements->pdata[2]), ==, 3);
+
+      free_elements (elements);
+    }
+}
+
+static void
+test_strings (void)
+{
+  const gchar *data =
+    "[{\"id\": 1, \"text\": \"a \\\"quoted\\\" ] and [ or { } , \\\\\"},"
+    " \"]\\\"[,\"]";
+  gsize chunk_size;
+
+  for (chunk_size = 1; chunk_size <= strlen (data); chunk_size++)
+    {
+      GPtrArray *elements = g_ptr_array_new ();
+      GError *error = NULL;
+      JsonNode *text;
+
+      g_assert (parse_in_chunks (data, chunk_size, elements, &error));
+      g_assert (error == NULL);
+
+      g_assert_cmpuint (elements->len, ==, 2);
+
+      text = json_object_get_member (json_node_get_object (elements->pdata[0]),
+                                     "text");
+      g_assert_cmpstr (json_node_get_string (text),
+                       ==,
+                       "a \"quoted\" ] and [ or { } , \\");
+
+      g_assert (JSON_NODE_TYPE (elements->pdata[1]) == JSON_NODE_VALUE);
+      g_assert_cmpstr (json_node_get_string (elements->pdata[1]), ==, "]\"[,");
+
+      free_elements (elements);
+    }
+}
+
+static void
+test_scalars (void)
+{
+  GPtrArray *elements = g_ptr_array_new ();
+  GError *error = NULL;
+
+  g_assert (parse_in_chunks ("[42, \"two\", true , null,-1]", 3,
+                             elements,
+                             &error));
+  g_assert (error == NULL);
+
+  g_assert_cmpuint (elements->len, ==, 5);
+  g_assert_cmpint (json_node_get_int (elements->pdata[0]), ==, 42);
+  g_assert_cmpstr (json_node_get_string (elements->pdata[1]), ==, "two");
+  g_assert (json_node_get_boolean (elements->pdata[2]));
+  g_assert (JSON_NODE_TYPE (elements->pdata[3]) == JSON_NODE_NULL);
+  g_assert_cmpint (json_node_get_int (elements->pdata[4]), ==, -1);
+
+  free_elements (elements);
+}
+
+static void
+test_empty_array (void)
+{
+  GPtrArray *elements = g_ptr_array_new ();
+  GError *error = NULL;
+
+  g_assert (parse_in_chunks ("[]", 1, elements, &error));
+  g_assert (error == NULL);
+  g_assert_cmpuint (elements->len, ==, 0);
+
+  g_assert (parse_in_chunks ("  [ \n ]  ", 2, elements, &error));
+  g_assert (error == NULL);
+  g_assert_cmpuint (elements->len, ==, 0);
+
+  free_elements (elements);
+}
+
+static void
+test_invalid (void)
+{
+  const gchar *invalid[] = {
+    "[,]",
+    "[,,]",
+    "[1,]",
+    "[,1]",
+    "[1,,2]",
+    "[{} {}]",
+    "{\"id\": 1}",
+    "[1]]",
+    "[1] x",
+    "[{\"id\": 1}",
+    "[1,",
+    "",
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (invalid); i++)
+    {
+      GPtrArray *elements = g_ptr_array_new ();
+      GError *error = NULL;
+
+      if (g_test_verbose ())
+        g_print ("Parsing `%s'\n", invalid[i]);
+
+      g_assert (!parse_in_chunks (invalid[i], 1, elements, &error));
+      g_assert (error != NULL);
+
+      g_error_free (error);
+      free_elements (elements);
+    }
+}
+
+static void
+test_trailing_space (void)
+{
+  GPtrArray *elements = g_ptr_array_new ();
+  GError *error = NULL;
+
+  g_assert (parse_in_chunks ("[1]\r\n\t ", 1, elements, &error));
+  g_assert (error == NULL);
+  g_assert_cmpuint (elements->len, ==, 1);
+
+  free_elements (elements);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/stream-parser/split-chunks", test_split_chunks);
+  g_test_add_func ("/stream-parser/strings", test_strings);
+  g_test_add_func ("/stream-parser/scalars", test_scalars);
+  g_test_add_func ("/stream-parser/empty-array", test_empty_array);
+  g_test_add_func ("/stream-parser/invalid", test_invalid);
+  g_test_add_func ("/stream-parser/trailing-space", test_trailing_space);
+
+  return g_test_run ();
+}
@@ -107,6 +107,10 @@ main (int   argc,
     }
 
   client = twitter_client_new_for_user (argv[1], argv[2]);
+
+  /* parse the timeline synchronously, before emitting the signals */
+  g_object_set (G_OBJECT (client), "use-threads", FALSE, NULL);
+
   g_signal_connect (client, "authenticate",
                     G_CALLBACK (authenticate_cb),
                     NULL);
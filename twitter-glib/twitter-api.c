@@ -30,22 +30,30 @@
         "http://twitter.com/statuses/public_timeline.json"
 
 /* @param (optional): since=%s, http date (If-Modified-Since) */
+/* @param (optional): since_id=%u, newer than the status id */
+/* @param (optional): max_id=%u, older than or equal to the status id */
 #define TWITTER_API_FRIENDS_TIMELINE            \
         "http://twitter.com/statuses/friends_timeline.json"
 
 /* @param (required): id=%s, user id */
 /* @param (optional): since=%s, http date (If-Modified-Since) */
+/* @param (optional): since_id=%u, newer than the status id */
+/* @param (optional): max_id=%u, older than or equal to the status id */
 #define TWITTER_API_FRIENDS_TIMELINE_ID         \
         "http://twitter.com/statuses/friends_timeline/%s.json"
 
 /* @param (optional): since=%s, http date (If-Modified-Since) */
 /* @param (optional): count=%u, number of items (< 20) */
+/* @param (optional): since_id=%u, newer than the status id */
+/* @param (optional): max_id=%u, older than or equal to the status id */
 #define TWITTER_API_USER_TIMELINE               \
         "http://twitter.com/statuses/user_timeline.json"
 
 /* @param (required): id=%s, user id */
 /* @param (optional): since=%s, http date (If-Modified-Since) */
 /* @param (optional): count=%u, number of items (< 20) */
+/* @param (optional): since_id=%u, newer than the status id */
+/* @param (optional): max_id=%u, older than or equal to the status id */
 #define TWITTER_API_USER_TIMELINE_ID            \
         "http://twitter.com/statuses/user_timeline/%s.json"
 
@@ -146,37 +154,67 @@ twitter_api_public_timeline (gint since_id)
   return msg;
 }
 
+/* appends a parameter to the query part of @url */
+static void
+url_add_param (GString     *url,
+               const gchar *format,
+               ...)
+{
+  va_list args;
+
+  g_string_append_c (url, strchr (url->str, '?') != NULL ? '&' : '?');
+
+  va_start (args, format);
+  g_string_append_vprintf (url, format, args);
+  va_end (args);
+}
+
+static void
+message_set_since (SoupMessage *msg,
+                   gint64       since)
+{
+  SoupDate *since_date;
+  gchar *date;
+
+  since_date = soup_date_new_from_time_t ((time_t) since);
+  date = soup_date_to_string (since_date, SOUP_DATE_HTTP);
+
+  soup_message_headers_append (msg->request_headers,
+                               "If-Modified-Since",
+                               date);
+
+  g_free (date);
+  soup_date_free (since_date);
+}
+
 SoupMessage *
 twitter_api_friends_timeline (const gchar *user,
+                              guint        since_id,
+                              guint        max_id,
                               gint64       since)
 {
   SoupMessage *msg;
-  gchar *url;
+  GString *url;
+
+  url = g_string_new (NULL);
 
   if (user && *user != '\0')
-    url = g_strdup_printf (TWITTER_API_FRIENDS_TIMELINE_ID, user);
+    g_string_printf (url, TWITTER_API_FRIENDS_TIMELINE_ID, user);
   else
-    url = g_strdup (TWITTER_API_FRIENDS_TIMELINE);
+    g_string_assign (url, TWITTER_API_FRIENDS_TIMELINE);
 
-  msg = soup_message_new (SOUP_METHOD_GET, url);
+  if (since_id > 0)
+    url_add_param (url, "since_id=%u", since_id);
 
-  if (since > 0)
-    {
-      SoupDate *since_date;
-      gchar *date;
+  if (max_id > 0)
+    url_add_param (url, "max_id=%u", max_id);
 
-      since_date = soup_date_new_from_time_t ((time_t) since);
-      date = soup_date_to_string (since_date, SOUP_DATE_HTTP);
+  msg = soup_message_new (SOUP_METHOD_GET, url->str);
 
-      soup_message_headers_append (msg->request_headers,
-                                   "If-Modified-Since",
-                                   date);
+  if (since > 0)
+    message_set_since (msg, since);
 
-      g_free (date);
-      soup_date_free (since_date);
-    }
-
-  g_free (url);
+  g_string_free (url, TRUE);
 
   return msg;
 }
@@ -184,47 +222,35 @@ twitter_api_friends_timeline (const gchar *user,
 SoupMessage *
 twitter_api_user_timeline (const gchar *user,
                            guint        count,
+                           guint        since_id,
+                           guint        max_id,
                            gint64       since)
 {
   SoupMessage *msg;
-  gchar *url;
+  GString *url;
 
-  if (count > 0)
-    {
-      if (user && *user != '\0')
-        url = g_strdup_printf (TWITTER_API_USER_TIMELINE_ID "?count=%u",
-                               user,
-                               count);
-      else
-        url = g_strdup_printf (TWITTER_API_USER_TIMELINE "?count=%u", count);
-    }
+  url = g_string_new (NULL);
+
+  if (user && *user != '\0')
+    g_string_printf (url, TWITTER_API_USER_TIMELINE_ID, user);
   else
-    {
-      if (user && *user != '\0')
-        url = g_strdup_printf (TWITTER_API_USER_TIMELINE_ID, user);
-      else
-        url = g_strdup (TWITTER_API_USER_TIMELINE);
-    }
+    g_string_assign (url, TWITTER_API_USER_TIMELINE);
 
-  msg = soup_message_new (SOUP_METHOD_GET, url);
+  if (count > 0)
+    url_add_param (url, "count=%u", count);
 
-  if (since > 0)
-    {
-      SoupDate *since_date;
-      gchar *date;
+  if (since_id > 0)
+    url_add_param (url, "since_id=%u", since_id);
 
-      since_date = soup_date_new_from_time_t ((time_t) since);
-      date = soup_date_to_string (since_date, SOUP_DATE_HTTP);
+  if (max_id > 0)
+    url_add_param (url, "max_id=%u", max_id);
 
-      soup_message_headers_append (msg->request_headers,
-                                   "If-Modified-Since",
-                                   date);
+  msg = soup_message_new (SOUP_METHOD_GET, url->str);
 
-      g_free (date);
-      soup_date_free (since_date);
-    }
+  if (since > 0)
+    message_set_since (msg, since);
 
-  g_free (url);
+  g_string_free (url, TRUE);
 
   return msg;
 }
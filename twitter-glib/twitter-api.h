@@ -26,9 +26,13 @@ G_BEGIN_DECLS
 
 SoupMessage *twitter_api_public_timeline    (gint         since_id);
 SoupMessage *twitter_api_friends_timeline   (const gchar *user,
+                                             guint        since_id,
+                                             guint        max_id,
                                              gint64       since);
 SoupMessage *twitter_api_user_timeline      (const gchar *user,
                                              guint        count,
+                                             guint        since_id,
+                                             guint        max_id,
                                              gint64       since);
 SoupMessage *twitter_api_status_show        (guint        status_id);
 SoupMessage *twitter_api_update             (const gchar *text);
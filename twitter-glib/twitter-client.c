@@ -58,7 +58,9 @@
 #endif
 
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include <glib/gstdio.h>
 #include <gio/gio.h>
@@ -72,6 +74,7 @@
 #include "twitter-marshal.h"
 #include "twitter-private.h"
 #include "twitter-status.h"
+#include "twitter-stream-parser.h"
 #include "twitter-timeline.h"
 #include "twitter-user.h"
 #include "twitter-user-list.h"
@@ -93,7 +96,32 @@ struct _TwitterClientPrivate
 
   gulong auth_id;
 
+  /* user id -> TwitterUser, shared by every status we receive */
+  GHashTable *users;
+
+  /* request key -> SoupMessage, for the requests in flight */
+  GHashTable *pending;
+
+  /* request id -> RequestHandle, for the requests not finished yet */
+  GHashTable *requests;
+  guint last_request_id;
+
+  /* request scheduling */
+  GQueue interactive_queue;
+  GQueue background_queue;
+  guint n_in_flight;
+  guint dispatch_id;
+
+  /* the API calls left, or -1 if unknown, and when they are reset */
+  gint rate_remaining;
+  time_t rate_reset;
+
+  guint n_failures;
+  time_t backoff_until;
+
   guint auth_complete : 1;
+  guint use_threads   : 1;
+  guint streaming     : 1;
 };
 
 enum
@@ -102,7 +130,9 @@ enum
 
   PROP_EMAIL,
   PROP_PASSWORD,
-  PROP_USER_AGENT
+  PROP_USER_AGENT,
+  PROP_USE_THREADS,
+  PROP_STREAMING
 };
 
 enum
@@ -112,12 +142,19 @@ enum
   USER_RECEIVED,
   TIMELINE_COMPLETE,
   USER_VERIFIED,
+  TIMELINE_RECEIVED,
 
   LAST_SIGNAL
 };
 
 static guint client_signals[LAST_SIGNAL] = { 0, };
 
+/* set on the timelines whose statuses were emitted while parsing */
+static GQuark quark_streamed = 0;
+
+/* the GCancellable of the request that retrieved a timeline */
+static GQuark quark_cancellable = 0;
+
 G_DEFINE_TYPE (TwitterClient, twitter_client, G_TYPE_OBJECT);
 
 #ifdef TWEET_ENABLE_DEBUG
@@ -132,6 +169,33 @@ twitter_debug (const gchar *action,
 # define twitter_debug(a,b)
 #endif /* TWEET_ENABLE_DEBUG */
 
+static void twitter_client_drop_queue (GQueue *queue);
+static void request_handle_unlink     (gpointer key,
+                                       gpointer value,
+                                       gpointer data);
+
+static void
+twitter_client_dispose (GObject *gobject)
+{
+  TwitterClientPrivate *priv = TWITTER_CLIENT (gobject)->priv;
+
+  if (priv->dispatch_id)
+    {
+      g_source_remove (priv->dispatch_id);
+      priv->dispatch_id = 0;
+    }
+
+  /* the requests that were not sent yet hold a reference on the
+   * client, so the client cannot be finalized until they have been
+   * sent; dropping them here breaks the cycle when the client is
+   * explicitly disposed
+   */
+  twitter_client_drop_queue (&priv->interactive_queue);
+  twitter_client_drop_queue (&priv->background_queue);
+
+  G_OBJECT_CLASS (twitter_client_parent_class)->dispose (gobject);
+}
+
 static void
 twitter_client_finalize (GObject *gobject)
 {
@@ -140,6 +204,12 @@ twitter_client_finalize (GObject *gobject)
   soup_session_abort (priv->session_async);
   g_object_unref (priv->session_async);
 
+  twitter_user_registry_destroy (priv->users);
+  g_hash_table_destroy (priv->pending);
+
+  g_hash_table_foreach (priv->requests, request_handle_unlink, NULL);
+  g_hash_table_destroy (priv->requests);
+
   g_free (priv->user_agent);
   g_free (priv->email);
   g_free (priv->password);
@@ -172,6 +242,14 @@ twitter_client_set_property (GObject      *gobject,
       priv->user_agent = g_value_dup_string (value);
       break;
 
+    case PROP_USE_THREADS:
+      priv->use_threads = g_value_get_boolean (value);
+      break;
+
+    case PROP_STREAMING:
+      priv->streaming = g_value_get_boolean (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -200,6 +278,14 @@ twitter_client_get_property (GObject    *gobject,
       g_value_set_string (value, priv->user_agent);
       break;
 
+    case PROP_USE_THREADS:
+      g_value_set_boolean (value, priv->use_threads);
+      break;
+
+    case PROP_STREAMING:
+      g_value_set_boolean (value, priv->streaming);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, prop_id, pspec);
       break;
@@ -223,6 +309,10 @@ twitter_client_constructed (GObject *gobject)
   g_free (user_agent);
 }
 
+static void twitter_client_real_timeline_received (TwitterClient   *client,
+                                                   TwitterTimeline *timeline,
+                                                   const GError    *error);
+
 static void
 twitter_client_class_init (TwitterClientClass *klass)
 {
@@ -230,9 +320,15 @@ twitter_client_class_init (TwitterClientClass *klass)
 
   g_type_class_add_private (klass, sizeof (TwitterClientPrivate));
 
+  quark_streamed = g_quark_from_static_string ("twitter-client-streamed");
+  quark_cancellable = g_quark_from_static_string ("twitter-client-cancellable");
+
+  klass->timeline_received = twitter_client_real_timeline_received;
+
   gobject_class->constructed = twitter_client_constructed;
   gobject_class->set_property = twitter_client_set_property;
   gobject_class->get_property = twitter_client_get_property;
+  gobject_class->dispose = twitter_client_dispose;
   gobject_class->finalize = twitter_client_finalize;
 
   g_object_class_install_property (gobject_class,
@@ -256,6 +352,47 @@ twitter_client_class_init (TwitterClientClass *klass)
                                                         "The client name to be used when connecting",
                                                         NULL,
                                                         G_PARAM_CONSTRUCT_ONLY | G_PARAM_READWRITE));
+  /**
+   * TwitterClient:use-threads:
+   *
+   * Whether the timelines and user lists should be parsed inside a
+   * separate thread, to avoid blocking the main loop. Threads are
+   * used only if the GLib threading system has been initialized
+   * with g_thread_init().
+   *
+   * Setting this property to %FALSE will parse the data inside the
+   * main loop, before emitting the signals; this is mostly useful
+   * for testing purposes.
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_USE_THREADS,
+                                   g_param_spec_boolean ("use-threads",
+                                                         "Use Threads",
+                                                         "Whether to parse the received data in a separate thread",
+                                                         TRUE,
+                                                         G_PARAM_READWRITE));
+  /**
+   * TwitterClient:streaming:
+   *
+   * Whether the timelines should be parsed while they are being
+   * downloaded, instead of waiting for the whole response.
+   *
+   * If this property is set to %TRUE, the #TwitterClient::status-received
+   * signal is emitted for each status as soon as it has been parsed;
+   * the #TwitterClient::timeline-received signal is then emitted once
+   * the download is complete, and its default handler will only emit
+   * the #TwitterClient::timeline-complete signal.
+   *
+   * Streamed timelines are always parsed inside the main loop, so
+   * this property takes precedence over #TwitterClient:use-threads.
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_STREAMING,
+                                   g_param_spec_boolean ("streaming",
+                                                         "Streaming",
+                                                         "Whether to parse the timelines while downloading them",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE));
 
   /**
    * TwitterClient::authenticate:
@@ -336,6 +473,32 @@ twitter_client_class_init (TwitterClientClass *klass)
                   NULL, NULL,
                   _twitter_marshal_VOID__VOID,
                   G_TYPE_NONE, 0);
+  /**
+   * TwitterClient::timeline-received:
+   * @client: the #TwitterClient that received the signal
+   * @timeline: the received #TwitterTimeline, or %NULL
+   * @error: a #GError, or %NULL
+   *
+   * The ::timeline-received signal is emitted once for each timeline
+   * requested, with every status it contains. In case of error,
+   * @timeline will be %NULL and @error will be set.
+   *
+   * The default handler emits the #TwitterClient::status-received
+   * signal for each status inside @timeline, followed by the
+   * #TwitterClient::timeline-complete signal, from an idle handler.
+   * Handlers dealing with the whole timeline can skip this by
+   * calling g_signal_stop_emission_by_name().
+   */
+  client_signals[TIMELINE_RECEIVED] =
+    g_signal_new (I_("timeline-received"),
+                  G_TYPE_FROM_CLASS (gobject_class),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (TwitterClientClass, timeline_received),
+                  NULL, NULL,
+                  _twitter_marshal_VOID__OBJECT_POINTER,
+                  G_TYPE_NONE, 2,
+                  TWITTER_TYPE_TIMELINE,
+                  G_TYPE_POINTER);
 }
 
 static void
@@ -346,6 +509,17 @@ twitter_client_init (TwitterClient *client)
   client->priv = priv = TWITTER_CLIENT_GET_PRIVATE (client);
 
   priv->auth_id = 0;
+  priv->use_threads = TRUE;
+
+  priv->rate_remaining = -1;
+
+  priv->users = twitter_user_registry_new ();
+  priv->pending = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         g_free,
+                                         g_object_unref);
+  priv->requests = g_hash_table_new_full (NULL, NULL,
+                                          NULL,
+                                          g_free);
 }
 
 typedef enum {
@@ -401,9 +575,26 @@ static const gchar *action_names[N_CLIENT_ACTIONS] = {
 };
 #endif /* TWEET_ENABLE_DEBUG */
 
+typedef enum {
+  REQUEST_INTERACTIVE,
+  REQUEST_BACKGROUND
+} RequestPriority;
+
 typedef struct {
   ClientAction action;
   TwitterClient *client;
+
+  /* cancelled by twitter_client_cancel_request() */
+  GCancellable *cancellable;
+
+  /* the message of the request, if identical requests can be
+   * coalesced with it; see twitter_client_check_pending()
+   */
+  SoupMessage *pending_msg;
+
+  /* releases the closure and its contents */
+  GDestroyNotify free_func;
+
   guint requires_auth : 1;
 } ClientClosure;
 
@@ -413,6 +604,10 @@ typedef struct {
 #define closure_get_client(c)           (((ClientClosure *) (c))->client)
 #define closure_set_requires_auth(c,v)  (((ClientClosure *) (c))->requires_auth) = (v)
 #define closure_get_requires_auth(c)    (((ClientClosure *) (c))->requires_auth)
+#define closure_get_cancellable(c)      (((ClientClosure *) (c))->cancellable)
+#define closure_is_cancelled(c)         (g_cancellable_is_cancelled (closure_get_cancellable (c)))
+#define closure_set_free_func(c,v)      (((ClientClosure *) (c))->free_func) = (v)
+#define closure_free(c)                 (((ClientClosure *) (c))->free_func (c))
 
 #ifdef TWEET_ENABLE_DEBUG
 #define closure_get_action_name(c)      (action_names[(((ClientClosure *) (c))->action)])
@@ -423,6 +618,12 @@ typedef struct {
 typedef struct {
   ClientClosure closure;
   TwitterTimeline *timeline;
+  TwitterStreamParser *stream;
+
+  /* the statuses parsed from the current chunk, newest last; they
+   * are emitted once the parser is done with the chunk
+   */
+  GList *streamed;
 } GetTimelineClosure;
 
 typedef struct {
@@ -444,6 +645,75 @@ typedef struct {
   ClientClosure closure;
 } VerifyClosure;
 
+static void pending_message_finished (SoupMessage   *msg,
+                                      TwitterClient *client);
+
+static void
+client_closure_free (gpointer data)
+{
+  ClientClosure *closure = data;
+
+  /* the result has been delivered, so the identical requests
+   * cannot be coalesced with this one anymore
+   */
+  if (closure->pending_msg)
+    {
+      pending_message_finished (closure->pending_msg, closure->client);
+      g_object_unref (closure->pending_msg);
+    }
+
+  if (closure->cancellable)
+    g_object_unref (closure->cancellable);
+
+  g_object_unref (closure->client);
+
+  g_free (closure);
+}
+
+static void
+get_timeline_closure_free (gpointer data)
+{
+  GetTimelineClosure *closure = data;
+
+  g_list_foreach (closure->streamed, (GFunc) g_object_unref, NULL);
+  g_list_free (closure->streamed);
+
+  twitter_stream_parser_free (closure->stream);
+  g_object_unref (closure->timeline);
+
+  client_closure_free (closure);
+}
+
+static void
+get_status_closure_free (gpointer data)
+{
+  GetStatusClosure *closure = data;
+
+  g_object_unref (closure->status);
+
+  client_closure_free (closure);
+}
+
+static void
+get_user_list_closure_free (gpointer data)
+{
+  GetUserListClosure *closure = data;
+
+  g_object_unref (closure->user_list);
+
+  client_closure_free (closure);
+}
+
+static void
+get_user_closure_free (gpointer data)
+{
+  GetUserClosure *closure = data;
+
+  g_object_unref (closure->user);
+
+  client_closure_free (closure);
+}
+
 static void
 twitter_client_auth (SoupSession *session,
                      SoupMessage *msg,
@@ -484,23 +754,589 @@ twitter_client_auth (SoupSession *session,
     }
 }
 
+/* the number of requests handed to the session at the same time; the
+ * other requests are kept inside the client queues, so that the
+ * interactive ones can overtake the background ones
+ */
+#define MAX_REQUESTS_IN_FLIGHT  2
+
+/* the number of API calls kept for the interactive requests; once
+ * the remaining calls reach this threshold, the background requests
+ * are deferred until the rate limit is reset
+ */
+#define RATE_LIMIT_RESERVE      10
+
+/* the delay before the first background request following a failure,
+ * doubled at every subsequent failure, in seconds
+ */
+#define BACKOFF_BASE            15
+#define BACKOFF_MAX             (15 * 60)
+
+typedef struct {
+  TwitterClient *client;
+  SoupMessage *msg;
+
+  SoupSessionCallback callback;
+  gpointer data;
+
+  GCancellable *cancellable;
+  gulong cancelled_id;
+
+  guint in_flight : 1;
+} QueuedRequest;
+
+/* maps a request id to the GCancellable of the request; the handle
+ * goes away with the cancellable, that is once the request has been
+ * completely processed
+ */
+typedef struct {
+  TwitterClient *client;
+  GCancellable *cancellable;
+  guint request_id;
+} RequestHandle;
+
+static void twitter_client_dispatch  (TwitterClient *client);
+
+static void
+request_handle_notify (gpointer  data,
+                       GObject  *where_the_object_was)
+{
+  RequestHandle *handle = data;
+  TwitterClientPrivate *priv = handle->client->priv;
+
+  g_hash_table_remove (priv->requests,
+                       GUINT_TO_POINTER (handle->request_id));
+}
+
+static void
+request_handle_unlink (gpointer key,
+                       gpointer value,
+                       gpointer data)
+{
+  RequestHandle *handle = value;
+
+  g_object_weak_unref (G_OBJECT (handle->cancellable),
+                       request_handle_notify,
+                       handle);
+}
+
+/* releases @request and its closure; the handler must be disconnected
+ * first, since the closure might hold the last reference on the
+ * cancellable
+ */
+static void
+queued_request_free (QueuedRequest *request,
+                     gboolean       free_closure)
+{
+  g_signal_handler_disconnect (request->cancellable,
+                               request->cancelled_id);
+
+  if (free_closure)
+    closure_free (request->data);
+
+  g_free (request);
+}
+
+static void
+twitter_client_drop_queue (GQueue *queue)
+{
+  QueuedRequest *request;
+
+  while ((request = g_queue_pop_head (queue)) != NULL)
+    {
+      SoupMessage *msg = request->msg;
+
+      queued_request_free (request, TRUE);
+      g_object_unref (msg);
+    }
+}
+
+static void
+twitter_client_update_rate_limit (TwitterClient *client,
+                                  SoupMessage   *msg)
+{
+  TwitterClientPrivate *priv = client->priv;
+  const gchar *header;
+
+  header = soup_message_headers_get (msg->response_headers,
+                                     "X-RateLimit-Remaining");
+  if (header)
+    priv->rate_remaining = atoi (header);
+
+  header = soup_message_headers_get (msg->response_headers,
+                                     "X-RateLimit-Reset");
+  if (header)
+    priv->rate_reset = (time_t) g_ascii_strtoull (header, NULL, 10);
+}
+
 static void
+twitter_client_update_backoff (TwitterClient *client,
+                               SoupMessage   *msg)
+{
+  TwitterClientPrivate *priv = client->priv;
+  guint status_code = msg->status_code;
+  guint delay;
+
+  if (SOUP_STATUS_IS_SUCCESSFUL (status_code) ||
+      status_code == SOUP_STATUS_NOT_MODIFIED)
+    {
+      priv->n_failures = 0;
+      priv->backoff_until = 0;
+      return;
+    }
+
+  /* only the failures that might go away by waiting count; Twitter
+   * uses 400 when the rate limit has been exceeded
+   */
+  if (status_code == SOUP_STATUS_CANCELLED ||
+      !(SOUP_STATUS_IS_TRANSPORT_ERROR (status_code) ||
+        SOUP_STATUS_IS_SERVER_ERROR (status_code) ||
+        status_code == SOUP_STATUS_BAD_REQUEST))
+    return;
+
+  priv->n_failures = MIN (priv->n_failures + 1, 16);
+
+  delay = MIN (BACKOFF_BASE << (priv->n_failures - 1), BACKOFF_MAX);
+
+  /* add some jitter, so that many clients failing at the same
+   * time do not retry at the same time as well
+   */
+  delay += g_random_int_range (0, delay / 2 + 1);
+
+  priv->backoff_until = time (NULL) + delay;
+}
+
+/* returns the number of seconds before the next background request
+ * can be started
+ */
+static guint
+twitter_client_get_background_delay (TwitterClient *client)
+{
+  TwitterClientPrivate *priv = client->priv;
+  time_t now = time (NULL);
+
+  if (priv->backoff_until > now)
+    return priv->backoff_until - now;
+
+  if (priv->rate_remaining >= 0 &&
+      priv->rate_remaining <= RATE_LIMIT_RESERVE &&
+      priv->rate_reset > now)
+    return priv->rate_reset - now;
+
+  return 0;
+}
+
+static void
+queued_request_cb (SoupSession *session,
+                   SoupMessage *msg,
+                   gpointer     user_data)
+{
+  QueuedRequest *request = user_data;
+  TwitterClient *client = request->client;
+  TwitterClientPrivate *priv = client->priv;
+
+  /* releasing the closure drops its reference on the client, which
+   * might be the last one; keep the client alive until the next
+   * request has been dispatched
+   */
+  g_object_ref (client);
+
+  priv->n_in_flight -= 1;
+
+  twitter_client_update_rate_limit (client, msg);
+  twitter_client_update_backoff (client, msg);
+
+  if (closure_is_cancelled (request->data))
+    queued_request_free (request, TRUE);
+  else
+    {
+      SoupSessionCallback callback = request->callback;
+      gpointer data = request->data;
+
+      queued_request_free (request, FALSE);
+
+      callback (session, msg, data);
+    }
+
+  twitter_client_dispatch (client);
+
+  g_object_unref (client);
+}
+
+static void
+queued_request_cancelled (GCancellable  *cancellable,
+                          QueuedRequest *request)
+{
+  TwitterClient *client = request->client;
+  TwitterClientPrivate *priv = client->priv;
+  SoupMessage *msg;
+
+  /* the completion callback will release the request */
+  if (request->in_flight)
+    {
+      soup_session_cancel_message (priv->session_async, request->msg,
+                                   SOUP_STATUS_CANCELLED);
+      return;
+    }
+
+  /* the request was never sent, so we own the message */
+  if (!g_queue_remove (&priv->interactive_queue, request))
+    g_queue_remove (&priv->background_queue, request);
+
+  msg = request->msg;
+
+  queued_request_free (request, TRUE);
+
+  g_object_unref (msg);
+}
+
+static gboolean
+dispatch_timeout (gpointer data)
+{
+  TwitterClient *client = data;
+
+  client->priv->dispatch_id = 0;
+
+  twitter_client_dispatch (client);
+
+  return FALSE;
+}
+
+static void
+twitter_client_dispatch (TwitterClient *client)
+{
+  TwitterClientPrivate *priv = client->priv;
+
+  while (priv->n_in_flight < MAX_REQUESTS_IN_FLIGHT)
+    {
+      QueuedRequest *request;
+
+      request = g_queue_pop_head (&priv->interactive_queue);
+      if (!request)
+        {
+          guint delay;
+
+          if (g_queue_is_empty (&priv->background_queue))
+            break;
+
+          delay = twitter_client_get_background_delay (client);
+          if (delay > 0)
+            {
+              if (!priv->dispatch_id)
+                priv->dispatch_id = g_timeout_add_seconds (delay,
+                                                           dispatch_timeout,
+                                                           client);
+              break;
+            }
+
+          request = g_queue_pop_head (&priv->background_queue);
+        }
+
+      /* every call counts against the rate limit; account for it
+       * until the server tells us the real number of remaining calls
+       */
+      if (priv->rate_remaining > 0)
+        priv->rate_remaining -= 1;
+
+      priv->n_in_flight += 1;
+      request->in_flight = TRUE;
+
+      soup_session_queue_message (priv->session_async, request->msg,
+                                  queued_request_cb,
+                                  request);
+    }
+}
+
+/*
+ * twitter_client_queue_message:
+ * @client: a #TwitterClient
+ * @msg: the #SoupMessage to send
+ * @requires_auth: whether the request needs authentication
+ * @priority: the priority of the request
+ * @callback: function called when the request is complete
+ * @data: the #ClientClosure of the request, passed to @callback
+ *
+ * Queues @msg. The interactive requests are always sent before the
+ * background ones, which are also deferred when the API calls left
+ * are running low, or after a failure.
+ *
+ * If the request is cancelled, @callback will not be called and the
+ * closure will be released using its free function.
+ *
+ * Return value: the id of the request
+ */
+static guint
 twitter_client_queue_message (TwitterClient       *client,
                               SoupMessage         *msg,
                               gboolean             requires_auth,
+                              RequestPriority      priority,
                               SoupSessionCallback  callback,
                               gpointer             data)
 {
   TwitterClientPrivate *priv = client->priv;
+  ClientClosure *closure = data;
+  QueuedRequest *request;
+  RequestHandle *handle;
 
   if (requires_auth && !priv->auth_id)
     priv->auth_id = g_signal_connect (priv->session_async, "authenticate",
                                       G_CALLBACK (twitter_client_auth),
                                       client);
 
-  soup_session_queue_message (priv->session_async, msg,
-                              callback,
-                              data);
+  handle = g_new (RequestHandle, 1);
+  handle->client = client;
+  handle->cancellable = g_cancellable_new ();
+
+  do
+    handle->request_id = ++priv->last_request_id;
+  while (handle->request_id == 0 ||
+         g_hash_table_lookup (priv->requests,
+                              GUINT_TO_POINTER (handle->request_id)));
+
+  g_hash_table_insert (priv->requests,
+                       GUINT_TO_POINTER (handle->request_id),
+                       handle);
+  g_object_weak_ref (G_OBJECT (handle->cancellable),
+                     request_handle_notify,
+                     handle);
+
+  /* the closure owns the only reference on the cancellable */
+  closure->cancellable = handle->cancellable;
+
+  /* the message stays pending until the closure is released */
+  if (g_object_get_data (G_OBJECT (msg), "twitter-request-key"))
+    closure->pending_msg = g_object_ref (msg);
+
+  g_object_set_data (G_OBJECT (msg), "twitter-request-id",
+                     GUINT_TO_POINTER (handle->request_id));
+
+  request = g_new0 (QueuedRequest, 1);
+  request->client = client;
+  request->msg = msg;
+  request->callback = callback;
+  request->data = data;
+  request->cancellable = closure->cancellable;
+  request->cancelled_id =
+    g_signal_connect (request->cancellable, "cancelled",
+                      G_CALLBACK (queued_request_cancelled),
+                      request);
+
+  if (priority == REQUEST_INTERACTIVE)
+    g_queue_push_tail (&priv->interactive_queue, request);
+  else
+    g_queue_push_tail (&priv->background_queue, request);
+
+  twitter_client_dispatch (client);
+
+  return handle->request_id;
+}
+
+static gchar *
+message_get_key (SoupMessage *msg)
+{
+  const gchar *since;
+  gchar *uri, *retval;
+
+  uri = soup_uri_to_string (soup_message_get_uri (msg), FALSE);
+  since = soup_message_headers_get (msg->request_headers,
+                                    "If-Modified-Since");
+
+  if (since)
+    retval = g_strconcat (msg->method, " ", uri, " ", since, NULL);
+  else
+    retval = g_strconcat (msg->method, " ", uri, NULL);
+
+  g_free (uri);
+
+  return retval;
+}
+
+static void
+pending_message_finished (SoupMessage   *msg,
+                          TwitterClient *client)
+{
+  TwitterClientPrivate *priv = client->priv;
+  const gchar *key;
+
+  key = g_object_get_data (G_OBJECT (msg), "twitter-request-key");
+  if (key && g_hash_table_lookup (priv->pending, key) == msg)
+    g_hash_table_remove (priv->pending, key);
+}
+
+/*
+ * twitter_client_check_pending:
+ * @client: a #TwitterClient
+ * @msg: a newly created #SoupMessage
+ *
+ * Checks whether a request identical to @msg, that is with the same
+ * method, URL and conditions, is already in flight. In that case @msg
+ * is released and the caller should not queue it: the result of the
+ * pending request will be emitted through the #TwitterClient signals,
+ * and thus delivered to every caller, who will also share the id of
+ * the pending request. Otherwise, @msg becomes the pending request
+ * until its result has been delivered, that is until the closure of
+ * the request is released; a cancelled request is not pending anymore.
+ *
+ * This function should only be used for requests without side effects.
+ *
+ * Return value: the id of the pending request, or 0 if @msg was
+ *   not coalesced with a pending request
+ */
+static guint
+twitter_client_check_pending (TwitterClient *client,
+                              SoupMessage   *msg)
+{
+  TwitterClientPrivate *priv = client->priv;
+  SoupMessage *pending;
+  gchar *key;
+
+  key = message_get_key (msg);
+
+  pending = g_hash_table_lookup (priv->pending, key);
+  if (pending)
+    {
+      RequestHandle *handle;
+      guint request_id;
+
+      request_id = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (pending),
+                                                        "twitter-request-id"));
+
+      /* the result of a cancelled request will never be delivered */
+      handle = g_hash_table_lookup (priv->requests,
+                                    GUINT_TO_POINTER (request_id));
+      if (handle && !g_cancellable_is_cancelled (handle->cancellable))
+        {
+          g_free (key);
+          g_object_unref (msg);
+
+          return request_id;
+        }
+    }
+
+  g_hash_table_replace (priv->pending, g_strdup (key), g_object_ref (msg));
+
+  g_object_set_data_full (G_OBJECT (msg), "twitter-request-key",
+                          key,
+                          g_free);
+
+  return 0;
+}
+
+typedef void (* ParseFunc)    (gpointer     closure,
+                               const gchar *buffer,
+                               gsize        length);
+typedef void (* CompleteFunc) (gpointer     closure);
+
+typedef struct {
+  gpointer closure;
+  SoupBuffer *buffer;
+
+  ParseFunc parse_func;
+  CompleteFunc complete_func;
+} ParseJob;
+
+static GThreadPool *parse_pool = NULL;
+
+static gboolean
+parse_job_complete (gpointer data)
+{
+  ParseJob *job = data;
+
+  if (G_UNLIKELY (job->buffer->length == 0))
+    g_warning ("No data received");
+
+  if (closure_is_cancelled (job->closure))
+    closure_free (job->closure);
+  else
+    job->complete_func (job->closure);
+
+  soup_buffer_free (job->buffer);
+  g_free (job);
+
+  return FALSE;
+}
+
+static void
+parse_job_run (gpointer data,
+               gpointer pool_data)
+{
+  ParseJob *job = data;
+
+  if (G_LIKELY (job->buffer->length > 0) &&
+      !closure_is_cancelled (job->closure))
+    job->parse_func (job->closure, job->buffer->data, job->buffer->length);
+
+  /* the rest of the processing must happen inside the main loop */
+  g_idle_add_full (G_PRIORITY_DEFAULT,
+                   parse_job_complete,
+                   job,
+                   NULL);
+}
+
+/*
+ * twitter_client_parse:
+ * @client: a #TwitterClient
+ * @closure: the closure of the request
+ * @buffer: the received data; the function takes ownership of it
+ * @parse_func: function building the result from @buffer; it must
+ *   not emit signals, since it might be called from a thread
+ * @complete_func: function called inside the main loop once the
+ *   result has been built; if the request is cancelled in the
+ *   meantime the closure is released instead
+ *
+ * Builds the result of a request, using the parsing threads if
+ * possible.
+ */
+static void
+twitter_client_parse (TwitterClient *client,
+                      gpointer       closure,
+                      SoupBuffer    *buffer,
+                      ParseFunc      parse_func,
+                      CompleteFunc   complete_func)
+{
+  TwitterClientPrivate *priv = client->priv;
+  ParseJob *job;
+
+  if (priv->use_threads && g_thread_supported () && !parse_pool)
+    {
+      GError *error = NULL;
+
+      parse_pool = g_thread_pool_new (parse_job_run, NULL,
+                                      2, FALSE,
+                                      &error);
+      if (error)
+        {
+          g_warning ("Unable to create the parsing threads: %s",
+                     error->message);
+          g_error_free (error);
+        }
+    }
+
+  if (!priv->use_threads || !parse_pool)
+    {
+      if (G_LIKELY (buffer->length > 0))
+        parse_func (closure, buffer->data, buffer->length);
+      else
+        g_warning ("No data received");
+
+      /* the signal handlers might cancel the request */
+      if (closure_is_cancelled (closure))
+        closure_free (closure);
+      else
+        complete_func (closure);
+
+      soup_buffer_free (buffer);
+
+      return;
+    }
+
+  job = g_new (ParseJob, 1);
+  job->closure = closure;
+  job->buffer = buffer;
+  job->parse_func = parse_func;
+  job->complete_func = complete_func;
+
+  g_thread_pool_push (parse_pool, job, NULL);
 }
 
 TwitterClient *
@@ -560,30 +1396,26 @@ twitter_client_get_user (TwitterClient  *client,
 typedef struct {
   TwitterClient *client;
   TwitterUserList *user_list;
-  guint n_users;
-  guint current_user;
+  GCancellable *cancellable;
+  GList *users;
+  GList *current_user;
 } EmitUserClosure;
 
 static gboolean
 do_emit_user_received (gpointer data)
 {
   EmitUserClosure *closure = data;
-  TwitterUser *user;
 
-  user = twitter_user_list_get_pos (closure->user_list,
-                                    closure->current_user);
-  if (!user)
+  if (!closure->current_user ||
+      g_cancellable_is_cancelled (closure->cancellable))
     return FALSE;
 
   g_signal_emit (closure->client, client_signals[USER_RECEIVED], 0,
-                 user, NULL);
-
-  closure->current_user += 1;
+                 closure->current_user->data, NULL);
 
-  if (closure->current_user == closure->n_users)
-    return FALSE;
+  closure->current_user = closure->current_user->next;
 
-  return TRUE;
+  return closure->current_user != NULL;
 }
 
 static void
@@ -593,24 +1425,25 @@ cleanup_emit_user_received (gpointer data)
 
   g_object_unref (closure->client);
   g_object_unref (closure->user_list);
+  g_object_unref (closure->cancellable);
+  g_list_free (closure->users);
 
   g_free (closure);
 }
 
 static void
 emit_user_received (TwitterClient   *client,
-                    TwitterUserList *user_list)
+                    TwitterUserList *user_list,
+                    GCancellable    *cancellable)
 {
   EmitUserClosure *closure;
-  guint count;
-
-  count = twitter_user_list_get_count (user_list);
 
   closure = g_new (EmitUserClosure, 1);
   closure->client = g_object_ref (client);
   closure->user_list = g_object_ref (user_list);
-  closure->n_users = count;
-  closure->current_user = 0;
+  closure->cancellable = g_object_ref (cancellable);
+  closure->users = twitter_user_list_get_all (user_list);
+  closure->current_user = closure->users;
 
   g_idle_add_full (G_PRIORITY_DEFAULT_IDLE + 50,
                    do_emit_user_received,
@@ -654,7 +1487,6 @@ get_status_cb (SoupSession *session,
   else
     {
       gboolean retval = FALSE;
-      gchar *buffer;
 
       if (requires_auth && !priv->auth_complete)
         {
@@ -663,26 +1495,24 @@ get_status_cb (SoupSession *session,
           priv->auth_complete = TRUE;
         }
 
-      buffer = g_strndup (msg->response_body->data,
-                          msg->response_body->length);
-
-      twitter_debug (closure_get_action_name (closure), buffer);
+      twitter_debug (closure_get_action_name (closure),
+                     msg->response_body->data);
 
-      if (G_UNLIKELY (!buffer))
+      if (G_UNLIKELY (msg->response_body->length == 0))
         g_warning ("No data received");
       else
-        twitter_status_load_from_data (closure->status, buffer);
+        {
+          twitter_status_load_from_buffer (closure->status,
+                                           msg->response_body->data,
+                                           msg->response_body->length);
+          twitter_status_intern_user (closure->status, priv->users);
+        }
 
       g_signal_emit (client, client_signals[STATUS_RECEIVED], 0,
                      closure->status, NULL);
-
-      g_free (buffer);
     }
 
-  g_object_unref (closure->status);
-  g_object_unref (client);
-
-  g_free (closure);
+  closure_free (closure);
 }
 
 void
@@ -716,18 +1546,50 @@ verify_cb (SoupSession *session,
                      is_verified, NULL);
     }
 
-  g_object_unref (client);
-
-  g_free (closure);
+  closure_free (closure);
 }
 
+/**
+ * twitter_client_cancel_request:
+ * @client: a #TwitterClient
+ * @request_id: the id of a request, as returned by the #TwitterClient
+ *   functions
+ *
+ * Cancels the request identified by @request_id. If the request is
+ * still being downloaded or parsed it is stopped, and if its results
+ * are still being emitted no further signal will be emitted for it.
+ *
+ * Identical requests issued while the first one is still in flight
+ * share the same id, so cancelling one of them cancels all of them.
+ */
 void
+twitter_client_cancel_request (TwitterClient *client,
+                               guint          request_id)
+{
+  RequestHandle *handle;
+  GCancellable *cancellable;
+
+  g_return_if_fail (TWITTER_IS_CLIENT (client));
+  g_return_if_fail (request_id != 0);
+
+  handle = g_hash_table_lookup (client->priv->requests,
+                                GUINT_TO_POINTER (request_id));
+  if (!handle)
+    return;
+
+  /* cancelling might release the last reference held by the request */
+  cancellable = g_object_ref (handle->cancellable);
+  g_cancellable_cancel (cancellable);
+  g_object_unref (cancellable);
+}
+
+guint
 twitter_client_verify_user (TwitterClient *client)
 {
   VerifyClosure *clos;
   SoupMessage *msg;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
 
   msg = twitter_api_verify_credentials ();
 
@@ -735,10 +1597,12 @@ twitter_client_verify_user (TwitterClient *client)
   closure_set_action (clos, VERIFY_CREDENTIALS);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, client_closure_free);
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                verify_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_INTERACTIVE,
+                                       verify_cb,
+                                       clos);
 }
 
 static void
@@ -746,49 +1610,76 @@ end_session_cb (SoupSession *session,
                 SoupMessage *message,
                 gpointer     user_data)
 {
-  TwitterClient *client = user_data;
+  ClientClosure *closure = user_data;
+  TwitterClient *client = closure_get_client (closure);
 
   client->priv->auth_complete = FALSE;
+
+  closure_free (closure);
+}
+
+/* the session is usually ended right before releasing the client,
+ * so the closure does not hold a reference on it
+ */
+static void
+end_session_closure_free (gpointer data)
+{
+  ClientClosure *closure = data;
+
+  if (closure->cancellable)
+    g_object_unref (closure->cancellable);
+
+  g_free (closure);
 }
 
 void
 twitter_client_end_session (TwitterClient *client)
 {
+  ClientClosure *clos;
   SoupMessage *msg;
 
   g_return_if_fail (TWITTER_IS_CLIENT (client));
 
   msg = twitter_api_end_session ();
 
+  clos = g_new0 (ClientClosure, 1);
+  closure_set_action (clos, END_SESSION);
+  closure_set_client (clos, client);
+  closure_set_requires_auth (clos, FALSE);
+  closure_set_free_func (clos, end_session_closure_free);
+
   twitter_client_queue_message (client, msg, FALSE,
+                                REQUEST_INTERACTIVE,
                                 end_session_cb,
-                                client);
+                                clos);
 }
 
 typedef struct {
   TwitterClient *client;
   TwitterTimeline *timeline;
-  guint n_status;
-  guint current_status;
+  GCancellable *cancellable;
+  GList *statuses;
+  GList *current_status;
 } EmitStatusClosure;
 
 static gboolean
 do_emit_status_received (gpointer data)
 {
   EmitStatusClosure *closure = data;
-  TwitterStatus *status;
 
-  status = twitter_timeline_get_pos (closure->timeline,
-                                     closure->current_status);
-  if (!status)
+  if (closure->cancellable &&
+      g_cancellable_is_cancelled (closure->cancellable))
     return FALSE;
 
-  g_signal_emit (closure->client, client_signals[STATUS_RECEIVED], 0,
-                 status, NULL);
+  if (closure->current_status)
+    {
+      g_signal_emit (closure->client, client_signals[STATUS_RECEIVED], 0,
+                     closure->current_status->data, NULL);
 
-  closure->current_status += 1;
+      closure->current_status = closure->current_status->next;
+    }
 
-  if (closure->current_status == closure->n_status)
+  if (!closure->current_status)
     {
       g_signal_emit (closure->client, client_signals[TIMELINE_COMPLETE], 0);
       return FALSE;
@@ -804,24 +1695,53 @@ cleanup_emit_status_received (gpointer data)
 
   g_object_unref (closure->client);
   g_object_unref (closure->timeline);
+  g_list_free (closure->statuses);
+
+  if (closure->cancellable)
+    g_object_unref (closure->cancellable);
 
   g_free (closure);
 }
 
+/* the per-status emission is kept for compatibility with the clients
+ * written before the ::timeline-received signal was added
+ */
 static void
-emit_status_received (TwitterClient   *client,
-                      TwitterTimeline *timeline)
+twitter_client_real_timeline_received (TwitterClient   *client,
+                                       TwitterTimeline *timeline,
+                                       const GError    *error)
 {
   EmitStatusClosure *closure;
-  guint count;
 
-  count = twitter_timeline_get_count (timeline);
+  if (error)
+    {
+      g_signal_emit (client, client_signals[STATUS_RECEIVED], 0,
+                     NULL, error);
+      return;
+    }
+
+  /* the statuses have already been emitted while parsing */
+  if (g_object_get_qdata (G_OBJECT (timeline), quark_streamed))
+    {
+      GCancellable *cancellable;
+
+      cancellable = g_object_get_qdata (G_OBJECT (timeline),
+                                        quark_cancellable);
+      if (!cancellable || !g_cancellable_is_cancelled (cancellable))
+        g_signal_emit (client, client_signals[TIMELINE_COMPLETE], 0);
+
+      return;
+    }
 
   closure = g_new (EmitStatusClosure, 1);
   closure->client = g_object_ref (client);
   closure->timeline = g_object_ref (timeline);
-  closure->n_status = count;
-  closure->current_status = 0;
+  closure->cancellable = g_object_get_qdata (G_OBJECT (timeline),
+                                             quark_cancellable);
+  if (closure->cancellable)
+    g_object_ref (closure->cancellable);
+  closure->statuses = twitter_timeline_get_all (timeline);
+  closure->current_status = closure->statuses;
 
   g_idle_add_full (G_PRIORITY_DEFAULT_IDLE + 50,
                    do_emit_status_received,
@@ -829,6 +1749,109 @@ emit_status_received (TwitterClient   *client,
                    cleanup_emit_status_received);
 }
 
+static void
+get_timeline_parse (gpointer     data,
+                    const gchar *buffer,
+                    gsize        length)
+{
+  GetTimelineClosure *closure = data;
+
+  twitter_timeline_load_from_buffer (closure->timeline, buffer, length);
+}
+
+static void
+get_timeline_complete (gpointer data)
+{
+  GetTimelineClosure *closure = data;
+  TwitterClient *client = closure_get_client (closure);
+
+  twitter_timeline_intern_users (closure->timeline, client->priv->users);
+
+  g_signal_emit (client, client_signals[TIMELINE_RECEIVED], 0,
+                 closure->timeline, NULL);
+
+  closure_free (closure);
+}
+
+static void
+get_timeline_element (JsonNode *element,
+                      gpointer  data)
+{
+  GetTimelineClosure *closure = data;
+  TwitterClient *client = closure_get_client (closure);
+  TwitterStatus *status;
+
+  if (JSON_NODE_TYPE (element) != JSON_NODE_OBJECT)
+    return;
+
+  status = twitter_status_new_from_node (element);
+  if (!twitter_timeline_add_status (closure->timeline, status))
+    {
+      g_object_unref (status);
+      return;
+    }
+
+  twitter_status_intern_user (status, client->priv->users);
+
+  /* we cannot emit the signal from inside the parser, since the
+   * handlers might cancel the request and release the parser
+   */
+  closure->streamed = g_list_prepend (closure->streamed,
+                                      g_object_ref (status));
+}
+
+static void
+get_timeline_got_chunk (SoupMessage *msg,
+                        SoupBuffer  *chunk,
+                        gpointer     user_data)
+{
+  GetTimelineClosure *closure = user_data;
+  TwitterClient *client;
+  GCancellable *cancellable;
+  GList *statuses, *l;
+  GError *error = NULL;
+
+  /* the body of an error response is not a timeline */
+  if (!SOUP_STATUS_IS_SUCCESSFUL (msg->status_code) ||
+      closure_is_cancelled (closure))
+    return;
+
+  if (!twitter_stream_parser_feed (closure->stream,
+                                   chunk->data, chunk->length,
+                                   &error))
+    {
+      /* the error is reported only once */
+      if (error)
+        {
+          g_warning ("Unable to parse data into a timeline: %s",
+                     error->message);
+          g_error_free (error);
+        }
+    }
+
+  /* a signal handler might cancel the request, which releases the
+   * closure, so we only use our own references from now on
+   */
+  statuses = g_list_reverse (closure->streamed);
+  closure->streamed = NULL;
+
+  client = g_object_ref (closure_get_client (closure));
+  cancellable = g_object_ref (closure_get_cancellable (closure));
+
+  for (l = statuses; l != NULL; l = l->next)
+    {
+      if (!g_cancellable_is_cancelled (cancellable))
+        g_signal_emit (client, client_signals[STATUS_RECEIVED], 0,
+                       l->data, NULL);
+
+      g_object_unref (l->data);
+    }
+
+  g_list_free (statuses);
+  g_object_unref (cancellable);
+  g_object_unref (client);
+}
+
 static void
 get_timeline_cb (SoupSession *session,
                  SoupMessage *msg,
@@ -857,7 +1880,7 @@ get_timeline_cb (SoupSession *session,
                    twitter_error_from_status (msg->status_code),
                    msg->reason_phrase);
 
-      g_signal_emit (client, client_signals[STATUS_RECEIVED], 0,
+      g_signal_emit (client, client_signals[TIMELINE_RECEIVED], 0,
                      NULL, error);
 
       g_error_free (error);
@@ -865,7 +1888,6 @@ get_timeline_cb (SoupSession *session,
   else
     {
       gboolean retval = FALSE;
-      gchar *buffer;
 
       if (requires_auth && !priv->auth_complete)
         {
@@ -874,71 +1896,129 @@ get_timeline_cb (SoupSession *session,
           priv->auth_complete = TRUE;
         }
 
-      buffer = g_strndup (msg->response_body->data,
-                          msg->response_body->length);
-
-      if (G_UNLIKELY (!buffer))
-        g_warning ("No data received");
+      if (closure->stream)
+        {
+          GError *error = NULL;
+
+          if (!twitter_stream_parser_finish (closure->stream, &error) &&
+              error != NULL)
+            {
+              g_warning ("Unable to parse data into a timeline: %s",
+                         error->message);
+              g_error_free (error);
+            }
+
+          g_object_set_qdata (G_OBJECT (closure->timeline),
+                              quark_streamed,
+                              GINT_TO_POINTER (TRUE));
+
+          g_signal_emit (client, client_signals[TIMELINE_RECEIVED], 0,
+                         closure->timeline, NULL);
+        }
       else
-        twitter_timeline_load_from_data (closure->timeline, buffer);
+        {
+          /* the flattened body is shared, not copied */
+          twitter_client_parse (client, closure,
+                                soup_message_body_flatten (msg->response_body),
+                                get_timeline_parse,
+                                get_timeline_complete);
+
+          return;
+        }
+    }
+
+  closure_free (closure);
+}
 
-      emit_status_received (client, closure->timeline);
+static guint
+twitter_client_queue_timeline (TwitterClient      *client,
+                               SoupMessage        *msg,
+                               GetTimelineClosure *closure)
+{
+  guint request_id;
 
-      g_free (buffer);
+  if (client->priv->streaming)
+    {
+      closure->stream = twitter_stream_parser_new (get_timeline_element,
+                                                   closure);
+
+      /* we don't need the whole body, only the chunks */
+      soup_message_body_set_accumulate (msg->response_body, FALSE);
+      g_signal_connect (msg, "got-chunk",
+                        G_CALLBACK (get_timeline_got_chunk),
+                        closure);
     }
 
-  g_object_unref (closure->timeline);
-  g_object_unref (client);
+  request_id = twitter_client_queue_message (client, msg,
+                                             closure_get_requires_auth (closure),
+                                             REQUEST_BACKGROUND,
+                                             get_timeline_cb,
+                                             closure);
 
-  g_free (closure);
+  /* the default ::timeline-received handler needs to know whether
+   * the request has been cancelled while emitting the statuses
+   */
+  g_object_set_qdata_full (G_OBJECT (closure->timeline), quark_cancellable,
+                           g_object_ref (closure_get_cancellable (closure)),
+                           (GDestroyNotify) g_object_unref);
+
+  return request_id;
 }
 
-void
+guint
 twitter_client_get_public_timeline (TwitterClient *client,
                                     guint          since_id)
 {
   GetTimelineClosure *clos;
   SoupMessage *msg;
+  guint request_id;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
 
   msg = twitter_api_public_timeline (since_id);
 
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
+
   clos = g_new0 (GetTimelineClosure, 1);
   closure_set_action (clos, PUBLIC_TIMELINE);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, FALSE);
+  closure_set_free_func (clos, get_timeline_closure_free);
   clos->timeline = twitter_timeline_new ();
 
-  twitter_client_queue_message (client, msg, FALSE,
-                                get_timeline_cb,
-                                clos);
+  return twitter_client_queue_timeline (client, msg, clos);
 }
 
-void
+guint
 twitter_client_get_friends_timeline (TwitterClient *client,
                                      const gchar   *friend_,
                                      gint64         since_date)
 {
   GetTimelineClosure *clos;
   SoupMessage *msg;
+  guint request_id;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
 
-  msg = twitter_api_friends_timeline (friend_, since_date);
+  msg = twitter_api_friends_timeline (friend_, 0, 0, since_date);
+
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
 
   clos = g_new0 (GetTimelineClosure, 1);
   closure_set_action (clos, FRIENDS_TIMELINE);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_timeline_closure_free);
   clos->timeline = twitter_timeline_new ();
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_timeline_cb,
-                                clos);
+  return twitter_client_queue_timeline (client, msg, clos);
 }
 
-void
+guint
 twitter_client_get_user_timeline (TwitterClient *client,
                                   const gchar   *user,
                                   guint          count,
@@ -946,86 +2026,159 @@ twitter_client_get_user_timeline (TwitterClient *client,
 {
   GetTimelineClosure *clos;
   SoupMessage *msg;
+  guint request_id;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
 
-  msg = twitter_api_user_timeline (user, count, since_date);
+  msg = twitter_api_user_timeline (user, count, 0, 0, since_date);
+
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
 
   clos = g_new0 (GetTimelineClosure, 1);
   closure_set_action (clos, USER_TIMELINE);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_timeline_closure_free);
   clos->timeline = twitter_timeline_new ();
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_timeline_cb,
-                                clos);
+  return twitter_client_queue_timeline (client, msg, clos);
 }
 
-void
+guint
+twitter_client_get_friends_timeline_range (TwitterClient *client,
+                                           const gchar   *friend_,
+                                           guint          since_id,
+                                           guint          max_id)
+{
+  GetTimelineClosure *clos;
+  SoupMessage *msg;
+  guint request_id;
+
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+
+  msg = twitter_api_friends_timeline (friend_, since_id, max_id, 0);
+
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
+
+  clos = g_new0 (GetTimelineClosure, 1);
+  closure_set_action (clos, FRIENDS_TIMELINE);
+  closure_set_client (clos, g_object_ref (client));
+  closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_timeline_closure_free);
+  clos->timeline = twitter_timeline_new ();
+
+  return twitter_client_queue_timeline (client, msg, clos);
+}
+
+guint
+twitter_client_get_user_timeline_range (TwitterClient *client,
+                                        const gchar   *user,
+                                        guint          count,
+                                        guint          since_id,
+                                        guint          max_id)
+{
+  GetTimelineClosure *clos;
+  SoupMessage *msg;
+  guint request_id;
+
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+
+  msg = twitter_api_user_timeline (user, count, since_id, max_id, 0);
+
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
+
+  clos = g_new0 (GetTimelineClosure, 1);
+  closure_set_action (clos, USER_TIMELINE);
+  closure_set_client (clos, g_object_ref (client));
+  closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_timeline_closure_free);
+  clos->timeline = twitter_timeline_new ();
+
+  return twitter_client_queue_timeline (client, msg, clos);
+}
+
+guint
 twitter_client_get_replies (TwitterClient *client)
 {
   GetTimelineClosure *clos;
   SoupMessage *msg;
+  guint request_id;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
 
   msg = twitter_api_replies ();
 
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
+
   clos = g_new0 (GetTimelineClosure, 1);
   closure_set_action (clos, STATUS_REPLIES);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_timeline_closure_free);
   clos->timeline = twitter_timeline_new ();
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_timeline_cb,
-                                clos);
+  return twitter_client_queue_timeline (client, msg, clos);
 }
 
-void
+guint
 twitter_client_get_favorites (TwitterClient *client,
                               const gchar   *user,
                               gint           page)
 {
   GetTimelineClosure *clos;
   SoupMessage *msg;
+  guint request_id;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
 
   msg = twitter_api_favorites (user, page);
 
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
+
   clos = g_new0 (GetTimelineClosure, 1);
   closure_set_action (clos, FAVORITES);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_timeline_closure_free);
   clos->timeline = twitter_timeline_new ();
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_timeline_cb,
-                                clos);
+  return twitter_client_queue_timeline (client, msg, clos);
 }
 
-void
+guint
 twitter_client_get_archive (TwitterClient *client,
                             gint           page)
 {
   GetTimelineClosure *clos;
   SoupMessage *msg;
+  guint request_id;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
 
   msg = twitter_api_archive (page);
 
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
+
   clos = g_new0 (GetTimelineClosure, 1);
   closure_set_action (clos, ARCHIVE);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_timeline_closure_free);
   clos->timeline = twitter_timeline_new ();
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_timeline_cb,
-                                clos);
+  return twitter_client_queue_timeline (client, msg, clos);
 }
 
 static void
@@ -1063,8 +2216,8 @@ get_user_cb (SoupSession *session,
     }
   else
     {
+      TwitterUser *user = closure->user;
       gboolean retval = FALSE;
-      gchar *buffer;
 
       if (requires_auth && !priv->auth_complete)
         {
@@ -1073,60 +2226,65 @@ get_user_cb (SoupSession *session,
           priv->auth_complete = TRUE;
         }
 
-      buffer = g_strndup (msg->response_body->data,
-                          msg->response_body->length);
+      twitter_debug (closure_get_action_name (closure),
+                     msg->response_body->data);
 
-      twitter_debug (closure_get_action_name (closure), buffer);
-
-      if (G_UNLIKELY (!buffer))
+      if (G_UNLIKELY (msg->response_body->length == 0))
         g_warning ("No data received");
       else
-        twitter_user_load_from_data (closure->user, buffer);
+        {
+          twitter_user_load_from_buffer (closure->user,
+                                         msg->response_body->data,
+                                         msg->response_body->length);
+          user = twitter_user_registry_intern (priv->users, closure->user);
+        }
 
       g_signal_emit (client, client_signals[USER_RECEIVED], 0,
-                     closure->user, NULL);
-
-      g_free (buffer);
+                     user, NULL);
     }
 
-  g_object_unref (closure->user);
-  g_object_unref (client);
-
-  g_free (closure);
+  closure_free (closure);
 }
 
-void
+guint
 twitter_client_get_status (TwitterClient *client,
                            guint          status_id)
 {
   GetStatusClosure *clos;
   SoupMessage *msg;
+  guint request_id;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
-  g_return_if_fail (status_id > 0);
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+  g_return_val_if_fail (status_id > 0, 0);
 
   msg = twitter_api_status_show (status_id);
 
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
+
   clos = g_new0 (GetStatusClosure, 1);
   closure_set_action (clos, STATUS_SHOW);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, FALSE);
+  closure_set_free_func (clos, get_status_closure_free);
   clos->status = twitter_status_new ();
 
-  twitter_client_queue_message (client, msg, FALSE,
-                                get_status_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, FALSE,
+                                       REQUEST_INTERACTIVE,
+                                       get_status_cb,
+                                       clos);
 }
 
-void
+guint
 twitter_client_add_status (TwitterClient *client,
                            const gchar   *text)
 {
   GetStatusClosure *clos;
   SoupMessage *msg;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
-  g_return_if_fail (text != NULL);
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+  g_return_val_if_fail (text != NULL, 0);
 
   msg = twitter_api_update (text);
 
@@ -1134,22 +2292,24 @@ twitter_client_add_status (TwitterClient *client,
   closure_set_action (clos, STATUS_UPDATE);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_status_closure_free);
   clos->status = twitter_status_new ();
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_status_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_INTERACTIVE,
+                                       get_status_cb,
+                                       clos);
 }
 
-void
+guint
 twitter_client_remove_status (TwitterClient *client,
                               guint          status_id)
 {
   GetStatusClosure *clos;
   SoupMessage *msg;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
-  g_return_if_fail (status_id > 0);
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+  g_return_val_if_fail (status_id > 0, 0);
 
   msg = twitter_api_destroy (status_id);
 
@@ -1157,11 +2317,37 @@ twitter_client_remove_status (TwitterClient *client,
   closure_set_action (clos, STATUS_DESTROY);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_status_closure_free);
   clos->status = twitter_status_new ();
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_status_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_INTERACTIVE,
+                                       get_status_cb,
+                                       clos);
+}
+
+static void
+get_user_list_parse (gpointer     data,
+                     const gchar *buffer,
+                     gsize        length)
+{
+  GetUserListClosure *closure = data;
+
+  twitter_user_list_load_from_buffer (closure->user_list, buffer, length);
+}
+
+static void
+get_user_list_complete (gpointer data)
+{
+  GetUserListClosure *closure = data;
+  TwitterClient *client = closure_get_client (closure);
+
+  twitter_user_list_intern_users (closure->user_list, client->priv->users);
+
+  emit_user_received (client, closure->user_list,
+                      closure_get_cancellable (closure));
+
+  closure_free (closure);
 }
 
 static void
@@ -1200,7 +2386,6 @@ get_user_list_cb (SoupSession *session,
   else
     {
       gboolean retval = FALSE;
-      gchar *buffer;
 
       if (requires_auth && !priv->auth_complete)
         {
@@ -1209,34 +2394,26 @@ get_user_list_cb (SoupSession *session,
           priv->auth_complete = TRUE;
         }
 
-      buffer = g_strndup (msg->response_body->data,
-                          msg->response_body->length);
-
-      if (G_UNLIKELY (!buffer))
-        g_warning ("No data received");
-      else
-        twitter_user_list_load_from_data (closure->user_list, buffer);
-
-      emit_user_received (client, closure->user_list);
+      twitter_client_parse (client, closure,
+                            soup_message_body_flatten (msg->response_body),
+                            get_user_list_parse,
+                            get_user_list_complete);
 
-      g_free (buffer);
+      return;
     }
 
-  g_object_unref (closure->user_list);
-  g_object_unref (client);
-
-  g_free (closure);
+  closure_free (closure);
 }
 
-void
+guint
 twitter_client_add_friend (TwitterClient *client,
                            const gchar   *user)
 {
   GetUserClosure *clos;
   SoupMessage *msg;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
-  g_return_if_fail (user != NULL);
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+  g_return_val_if_fail (user != NULL, 0);
 
   msg = twitter_api_create_friend (user);
 
@@ -1244,22 +2421,24 @@ twitter_client_add_friend (TwitterClient *client,
   closure_set_action (clos, FRIEND_CREATE);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
-  clos->user = twitter_user_new ();
+  closure_set_free_func (clos, get_user_closure_free);
+  clos->user = g_object_ref_sink (twitter_user_new ());
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_user_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_INTERACTIVE,
+                                       get_user_cb,
+                                       clos);
 }
 
-void
+guint
 twitter_client_remove_friend (TwitterClient *client,
                               const gchar   *user)
 {
   GetUserClosure *clos;
   SoupMessage *msg;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
-  g_return_if_fail (user != NULL);
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+  g_return_val_if_fail (user != NULL, 0);
 
   msg = twitter_api_destroy_friend (user);
 
@@ -1267,22 +2446,24 @@ twitter_client_remove_friend (TwitterClient *client,
   closure_set_action (clos, FRIEND_DESTROY);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
-  clos->user = twitter_user_new ();
+  closure_set_free_func (clos, get_user_closure_free);
+  clos->user = g_object_ref_sink (twitter_user_new ());
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_user_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_INTERACTIVE,
+                                       get_user_cb,
+                                       clos);
 }
 
-void
+guint
 twitter_client_follow_user (TwitterClient *client,
                             const gchar   *user)
 {
   GetUserClosure *clos;
   SoupMessage *msg;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
-  g_return_if_fail (user != NULL);
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+  g_return_val_if_fail (user != NULL, 0);
 
   msg = twitter_api_follow (user);
 
@@ -1290,22 +2471,24 @@ twitter_client_follow_user (TwitterClient *client,
   closure_set_action (clos, NOTIFICATION_FOLLOW);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
-  clos->user = twitter_user_new ();
+  closure_set_free_func (clos, get_user_closure_free);
+  clos->user = g_object_ref_sink (twitter_user_new ());
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_user_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_INTERACTIVE,
+                                       get_user_cb,
+                                       clos);
 }
 
-void
+guint
 twitter_client_leave_user (TwitterClient  *client,
                            const gchar    *user)
 {
   GetUserClosure *clos;
   SoupMessage *msg;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
-  g_return_if_fail (user != NULL);
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+  g_return_val_if_fail (user != NULL, 0);
 
   msg = twitter_api_leave (user);
 
@@ -1313,22 +2496,24 @@ twitter_client_leave_user (TwitterClient  *client,
   closure_set_action (clos, NOTIFICATION_LEAVE);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
-  clos->user = twitter_user_new ();
+  closure_set_free_func (clos, get_user_closure_free);
+  clos->user = g_object_ref_sink (twitter_user_new ());
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_user_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_INTERACTIVE,
+                                       get_user_cb,
+                                       clos);
 }
 
-void
+guint
 twitter_client_add_favorite (TwitterClient  *client,
                              guint           status_id)
 {
   GetStatusClosure *clos;
   SoupMessage *msg;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
-  g_return_if_fail (status_id > 0);
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+  g_return_val_if_fail (status_id > 0, 0);
 
   msg = twitter_api_create_favorite (status_id);
 
@@ -1336,37 +2521,41 @@ twitter_client_add_favorite (TwitterClient  *client,
   closure_set_action (clos, FAVORITE_CREATE);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_status_closure_free);
   clos->status = twitter_status_new ();
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_status_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_INTERACTIVE,
+                                       get_status_cb,
+                                       clos);
 }
 
-void
+guint
 twitter_client_remove_favorite (TwitterClient  *client,
                                 guint           status_id)
 {
   GetStatusClosure *clos;
   SoupMessage *msg;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
-  g_return_if_fail (status_id > 0);
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+  g_return_val_if_fail (status_id > 0, 0);
 
   msg = twitter_api_destroy_favorite (status_id);
 
   clos = g_new0 (GetStatusClosure, 1);
   closure_set_action (clos, FAVORITE_DESTROY);
   closure_set_client (clos, g_object_ref (client));
-  closure_set_requires_auth (close, TRUE);
+  closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_status_closure_free);
   clos->status = twitter_status_new ();
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_status_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_INTERACTIVE,
+                                       get_status_cb,
+                                       clos);
 }
 
-void
+guint
 twitter_client_get_friends (TwitterClient *client,
                             const gchar   *user,
                             gint           page,
@@ -1374,87 +2563,115 @@ twitter_client_get_friends (TwitterClient *client,
 {
   GetUserListClosure *clos;
   SoupMessage *msg;
+  guint request_id;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
 
   msg = twitter_api_friends (user, page, omit_status);
 
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
+
   clos = g_new0 (GetUserListClosure, 1);
   closure_set_action (clos, FRIENDS);
   closure_set_client (clos, g_object_ref (client));
-  closure_set_requires_auth (close, TRUE);
+  closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_user_list_closure_free);
   clos->user_list = twitter_user_list_new ();
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_user_list_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_BACKGROUND,
+                                       get_user_list_cb,
+                                       clos);
 }
 
-void
+guint
 twitter_client_get_followers (TwitterClient *client,
                               gint           page,
                               gboolean       omit_status)
 {
   GetUserListClosure *clos;
   SoupMessage *msg;
+  guint request_id;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
 
   msg = twitter_api_followers (page, omit_status);
 
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
+
   clos = g_new0 (GetUserListClosure, 1);
   closure_set_action (clos, FOLLOWERS);
   closure_set_client (clos, g_object_ref (client));
-  closure_set_requires_auth (close, TRUE);
+  closure_set_requires_auth (clos, TRUE);
+  closure_set_free_func (clos, get_user_list_closure_free);
   clos->user_list = twitter_user_list_new ();
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_user_list_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_BACKGROUND,
+                                       get_user_list_cb,
+                                       clos);
 }
 
-void
+guint
 twitter_client_show_user_from_email (TwitterClient *client,
                                      const gchar   *email)
 {
   GetUserClosure *clos;
   SoupMessage *msg;
+  guint request_id;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
-  g_return_if_fail (email != NULL);
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+  g_return_val_if_fail (email != NULL, 0);
 
   msg = twitter_api_user_show (NULL, email);
 
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
+
   clos = g_new0 (GetUserClosure, 1);
   closure_set_action (clos, USER_SHOW);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, TRUE);
-  clos->user = twitter_user_new ();
+  closure_set_free_func (clos, get_user_closure_free);
+  clos->user = g_object_ref_sink (twitter_user_new ());
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_user_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_INTERACTIVE,
+                                       get_user_cb,
+                                       clos);
 }
 
-void
+guint
 twitter_client_show_user_from_id (TwitterClient *client,
                                   const gchar   *user)
 {
   GetUserClosure *clos;
   SoupMessage *msg;
+  guint request_id;
 
-  g_return_if_fail (TWITTER_IS_CLIENT (client));
-  g_return_if_fail (user != NULL);
+  g_return_val_if_fail (TWITTER_IS_CLIENT (client), 0);
+  g_return_val_if_fail (user != NULL, 0);
 
   msg = twitter_api_user_show (user, NULL);
 
+  request_id = twitter_client_check_pending (client, msg);
+  if (request_id != 0)
+    return request_id;
+
   clos = g_new0 (GetUserClosure, 1);
   closure_set_action (clos, USER_SHOW);
   closure_set_client (clos, g_object_ref (client));
   closure_set_requires_auth (clos, FALSE);
-  clos->user = twitter_user_new ();
+  closure_set_free_func (clos, get_user_closure_free);
+  clos->user = g_object_ref_sink (twitter_user_new ());
 
-  twitter_client_queue_message (client, msg, TRUE,
-                                get_user_cb,
-                                clos);
+  return twitter_client_queue_message (client, msg, TRUE,
+                                       REQUEST_INTERACTIVE,
+                                       get_user_cb,
+                                       clos);
 }
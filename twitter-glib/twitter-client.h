@@ -22,6 +22,7 @@
 #include <glib-object.h>
 
 #include <twitter-glib/twitter-status.h>
+#include <twitter-glib/twitter-timeline.h>
 #include <twitter-glib/twitter-user.h>
 
 G_BEGIN_DECLS
@@ -82,6 +83,8 @@ struct _TwitterClient
  * @user_received: class handler for the #TwitterClient::user-received signal
  * @timeline_complete: class handler for the #TwitterClient::timeline_complete
  *   signal
+ * @timeline_received: class handler for the #TwitterClient::timeline-received
+ *   signal
  *
  * Base class for #TwitterClient.
  */
@@ -110,9 +113,12 @@ struct _TwitterClientClass
 
   void     (* timeline_complete) (TwitterClient    *client);
 
+  void     (* timeline_received) (TwitterClient    *client,
+                                  TwitterTimeline  *timeline,
+                                  const GError     *error);
+
   /*< private >*/
   /* padding, for future expansion */
-  void     (* _twitter_padding1) (void);
   void     (* _twitter_padding2) (void);
   void     (* _twitter_padding3) (void);
   void     (* _twitter_padding4) (void);
@@ -134,56 +140,67 @@ void           twitter_client_set_user             (TwitterClient  *client,
 void           twitter_client_get_user             (TwitterClient  *client,
                                                     gchar         **email,
                                                     gchar         **password);
-void           twitter_client_verify_user          (TwitterClient  *client);
+guint          twitter_client_verify_user          (TwitterClient  *client);
 void           twitter_client_end_session          (TwitterClient  *client);
-void           twitter_client_show_user_from_id    (TwitterClient  *client,
+void           twitter_client_cancel_request       (TwitterClient  *client,
+                                                    guint           request_id);
+guint          twitter_client_show_user_from_id    (TwitterClient  *client,
                                                     const gchar    *user);
-void           twitter_client_show_user_from_email (TwitterClient  *client,
+guint          twitter_client_show_user_from_email (TwitterClient  *client,
                                                     const gchar    *email);
 
-void           twitter_client_get_public_timeline  (TwitterClient  *client,
+guint          twitter_client_get_public_timeline  (TwitterClient  *client,
                                                     guint           since_id);
-void           twitter_client_get_friends_timeline (TwitterClient  *client,
+guint          twitter_client_get_friends_timeline (TwitterClient  *client,
                                                     const gchar    *friend_,
                                                     gint64          since_date);
-void           twitter_client_get_user_timeline    (TwitterClient  *client,
+guint          twitter_client_get_user_timeline    (TwitterClient  *client,
                                                     const gchar    *user,
                                                     guint           count,
                                                     gint64          since_date);
-void           twitter_client_get_replies          (TwitterClient  *client);
-void           twitter_client_get_favorites        (TwitterClient  *client,
+guint          twitter_client_get_friends_timeline_range (TwitterClient *client,
+                                                          const gchar   *friend_,
+                                                          guint          since_id,
+                                                          guint          max_id);
+guint          twitter_client_get_user_timeline_range    (TwitterClient *client,
+                                                          const gchar   *user,
+                                                          guint          count,
+                                                          guint          since_id,
+                                                          guint          max_id);
+guint          twitter_client_get_replies          (TwitterClient  *client);
+guint          twitter_client_get_favorites        (TwitterClient  *client,
                                                     const gchar    *user,
                                                     gint            page);
-void           twitter_client_get_archive          (TwitterClient  *client,
+guint          twitter_client_get_archive          (TwitterClient  *client,
                                                     gint            page);
-void           twitter_client_get_friends          (TwitterClient  *client,
+guint          twitter_client_get_friends          (TwitterClient  *client,
                                                     const gchar    *user,
                                                     gint            page,
                                                     gboolean        omit_status);
-void           twitter_client_get_followers        (TwitterClient  *client,
+guint          twitter_client_get_followers        (TwitterClient  *client,
                                                     gint            page,
                                                     gboolean        omit_status);
 
-void           twitter_client_get_status           (TwitterClient  *client,
+guint          twitter_client_get_status           (TwitterClient  *client,
                                                     guint           status_id);
-void           twitter_client_add_status           (TwitterClient  *client,
+guint          twitter_client_add_status           (TwitterClient  *client,
                                                     const gchar    *text);
-void           twitter_client_remove_status        (TwitterClient  *client,
+guint          twitter_client_remove_status        (TwitterClient  *client,
                                                     guint           status_id);
 
-void           twitter_client_add_friend           (TwitterClient  *client,
+guint          twitter_client_add_friend           (TwitterClient  *client,
                                                     const gchar    *user);
-void           twitter_client_remove_friend        (TwitterClient  *client,
+guint          twitter_client_remove_friend        (TwitterClient  *client,
                                                     const gchar    *user);
 
-void           twitter_client_follow_user          (TwitterClient  *client,
+guint          twitter_client_follow_user          (TwitterClient  *client,
                                                     const gchar    *user);
-void           twitter_client_leave_user           (TwitterClient  *client,
+guint          twitter_client_leave_user           (TwitterClient  *client,
                                                     const gchar    *user);
 
-void           twitter_client_add_favorite         (TwitterClient  *client,
+guint          twitter_client_add_favorite         (TwitterClient  *client,
                                                     guint           status_id);
-void           twitter_client_remove_favorite      (TwitterClient  *client,
+guint          twitter_client_remove_favorite      (TwitterClient  *client,
                                                     guint           status_id);
 
 G_END_DECLS
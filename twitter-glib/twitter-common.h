@@ -106,6 +106,18 @@ typedef enum {
   TWITTER_ERROR_NOT_MODIFIED
 } TwitterError;
 
+/**
+ * TwitterQueuePolicy:
+ * @TWITTER_QUEUE_FIFO: the oldest request is served first
+ * @TWITTER_QUEUE_LIFO: the newest request is served first
+ *
+ * The order in which queued requests are served.
+ */
+typedef enum {
+  TWITTER_QUEUE_FIFO,
+  TWITTER_QUEUE_LIFO
+} TwitterQueuePolicy;
+
 GQuark twitter_error_quark (void);
 
 TwitterError twitter_error_from_status (guint status);
@@ -0,0 +1,560 @@
+/* twitter-image-cache.c: On-disk cache for the profile images
+ *
+ * This file is part of Twitter-GLib.
+ * Copyright (C) 2008  Emmanuele Bassi  <ebassi@gnome.org>
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The profile images are stored inside $XDG_CACHE_HOME, one file for
+ * each image, named after the SHA1 of its URL. A single index file
+ * holds, for every image, its URL, size, the validators sent by the
+ * server and the last time it was used, so that looking up an image
+ * does not touch the disk. When the images exceed the maximum size of
+ * the cache, the ones used least recently are removed.
+ *
+ * The cached images are considered fresh for REVALIDATE_INTERVAL
+ * seconds; after that they should be downloaded again using the
+ * validators, so that the server can tell us they did not change.
+ *
+ * The cache can be updated from the image decoding threads, so every
+ * access to the index is protected by a lock. The index is written a
+ * few seconds after a change, and when the process exits.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include <glib/gstdio.h>
+
+#include "twitter-image-cache.h"
+
+#define DEFAULT_MAX_SIZE        (4 * 1024 * 1024)
+#define REVALIDATE_INTERVAL     (60 * 60 * 24)
+#define SAVE_INDEX_TIMEOUT      5
+
+#define INDEX_FILE              "index"
+
+typedef struct
+{
+  gchar *url;
+  gchar *file;
+
+  gchar *etag;
+  gchar *last_modified;
+
+  gsize size;
+
+  glong last_used;
+  glong validated;
+} CacheEntry;
+
+G_LOCK_DEFINE_STATIC (image_cache);
+
+static gchar *cache_dir = NULL;
+
+/* url -> CacheEntry */
+static GHashTable *cache_entries = NULL;
+
+static gsize cache_size = 0;
+static gsize cache_max_size = DEFAULT_MAX_SIZE;
+
+static guint save_index_id = 0;
+
+static glong
+get_current_time (void)
+{
+  GTimeVal now;
+
+  g_get_current_time (&now);
+
+  return now.tv_sec;
+}
+
+static void
+cache_entry_free (gpointer data)
+{
+  CacheEntry *entry = data;
+
+  g_free (entry->url);
+  g_free (entry->file);
+  g_free (entry->etag);
+  g_free (entry->last_modified);
+
+  g_slice_free (CacheEntry, entry);
+}
+
+static gchar *
+cache_entry_get_path (CacheEntry *entry)
+{
+  return g_build_filename (cache_dir, entry->file, NULL);
+}
+
+static gboolean
+save_index (gpointer data)
+{
+  GKeyFile *index;
+  GHashTableIter iter;
+  gpointer value;
+  gchar *contents, *index_file;
+  gsize length;
+  GError *error;
+
+  G_LOCK (image_cache);
+
+  save_index_id = 0;
+
+  index = g_key_file_new ();
+
+  g_hash_table_iter_init (&iter, cache_entries);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      CacheEntry *entry = value;
+
+      g_key_file_set_string (index, entry->file, "url", entry->url);
+      g_key_file_set_integer (index, entry->file, "size", entry->size);
+      g_key_file_set_integer (index, entry->file, "last-used", entry->last_used);
+      g_key_file_set_integer (index, entry->file, "validated", entry->validated);
+
+      if (entry->etag)
+        g_key_file_set_string (index, entry->file, "etag", entry->etag);
+
+      if (entry->last_modified)
+        g_key_file_set_string (index, entry->file, "last-modified",
+                               entry->last_modified);
+    }
+
+  G_UNLOCK (image_cache);
+
+  contents = g_key_file_to_data (index, &length, NULL);
+  index_file = g_build_filename (cache_dir, INDEX_FILE, NULL);
+
+  error = NULL;
+  g_file_set_contents (index_file, contents, length, &error);
+  if (error)
+    {
+      g_warning ("Unable to save the profile image cache index: %s",
+                 error->message);
+      g_error_free (error);
+    }
+
+  g_free (index_file);
+  g_free (contents);
+  g_key_file_free (index);
+
+  return FALSE;
+}
+
+/* the index is written only once for many changes; must be called
+ * with the lock held
+ */
+static void
+queue_save_index (void)
+{
+  if (save_index_id)
+    return;
+
+  save_index_id = g_timeout_add_seconds (SAVE_INDEX_TIMEOUT,
+                                         save_index,
+                                         NULL);
+}
+
+/* writes the index now if a change has not been saved yet */
+static void
+flush_index (void)
+{
+  guint save_id;
+
+  G_LOCK (image_cache);
+  save_id = save_index_id;
+  G_UNLOCK (image_cache);
+
+  if (save_id)
+    {
+      g_source_remove (save_id);
+      save_index (NULL);
+    }
+}
+
+static void
+load_index (void)
+{
+  GKeyFile *index;
+  GHashTable *files;
+  gchar *index_file;
+  gchar **groups;
+  const gchar *name;
+  GDir *dir;
+  struct stat index_stat;
+  time_t index_mtime;
+  gint i;
+
+  index = g_key_file_new ();
+  index_file = g_build_filename (cache_dir, INDEX_FILE, NULL);
+
+  files = g_hash_table_new (g_str_hash, g_str_equal);
+
+  index_mtime = 0;
+  if (g_stat (index_file, &index_stat) == 0)
+    index_mtime = index_stat.st_mtime;
+
+  groups = NULL;
+  if (g_key_file_load_from_file (index, index_file, G_KEY_FILE_NONE, NULL))
+    groups = g_key_file_get_groups (index, NULL);
+
+  for (i = 0; groups && groups[i] != NULL; i++)
+    {
+      CacheEntry *entry;
+      gchar *url;
+
+      url = g_key_file_get_string (index, groups[i], "url", NULL);
+      if (!url || g_hash_table_lookup (cache_entries, url))
+        {
+          g_free (url);
+          continue;
+        }
+
+      entry = g_slice_new0 (CacheEntry);
+      entry->url = url;
+      entry->file = g_strdup (groups[i]);
+      entry->etag = g_key_file_get_string (index, groups[i], "etag", NULL);
+      entry->last_modified =
+        g_key_file_get_string (index, groups[i], "last-modified", NULL);
+      entry->size = g_key_file_get_integer (index, groups[i], "size", NULL);
+      entry->last_used =
+        g_key_file_get_integer (index, groups[i], "last-used", NULL);
+      entry->validated =
+        g_key_file_get_integer (index, groups[i], "validated", NULL);
+
+      g_hash_table_insert (cache_entries, entry->url, entry);
+      g_hash_table_insert (files, entry->file, entry);
+      cache_size += entry->size;
+    }
+
+  g_key_file_free (index);
+  g_free (index_file);
+
+  /* remove the files that are not in the index, e.g. the ones
+   * written by previous versions, so that the cache stays bounded;
+   * the files written after the index was last saved are kept, as
+   * they were probably stored right before a crash, and they will
+   * be replaced the next time their image is downloaded
+   */
+  dir = g_dir_open (cache_dir, 0, NULL);
+  if (dir)
+    {
+      while ((name = g_dir_read_name (dir)) != NULL)
+        {
+          struct stat file_stat;
+          gchar *path;
+
+          if (strcmp (name, INDEX_FILE) == 0 ||
+              g_hash_table_lookup (files, name) != NULL)
+            continue;
+
+          path = g_build_filename (cache_dir, name, NULL);
+
+          if (index_mtime == 0 ||
+              g_stat (path, &file_stat) != 0 ||
+              file_stat.st_mtime < index_mtime)
+            g_unlink (path);
+
+          g_free (path);
+        }
+
+      g_dir_close (dir);
+    }
+
+  g_hash_table_destroy (files);
+  g_strfreev (groups);
+}
+
+/* must be called with the lock held */
+static void
+ensure_cache (void)
+{
+  if (G_LIKELY (cache_entries != NULL))
+    return;
+
+  cache_dir = g_build_filename (g_get_user_cache_dir (),
+                                "twitter-glib",
+                                "profile_images",
+                                NULL);
+
+  cache_entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                         NULL,
+                                         cache_entry_free);
+
+  /* the last changes are not lost if we exit before they are saved */
+  atexit (flush_index);
+
+  load_index ();
+}
+
+static gint
+compare_last_used (gconstpointer a,
+                   gconstpointer b)
+{
+  const CacheEntry *entry_a = a;
+  const CacheEntry *entry_b = b;
+
+  return entry_a->last_used - entry_b->last_used;
+}
+
+static void
+cache_remove_entry (CacheEntry *entry)
+{
+  gchar *path;
+
+  path = cache_entry_get_path (entry);
+  g_unlink (path);
+  g_free (path);
+
+  cache_size -= entry->size;
+
+  g_hash_table_remove (cache_entries, entry->url);
+}
+
+/* removes the least recently used images until the cache fits
+ * its maximum size; @keep is never removed. Must be called with
+ * the lock held
+ */
+static void
+cache_evict (CacheEntry *keep)
+{
+  GList *entries, *l;
+
+  if (cache_size <= cache_max_size)
+    return;
+
+  entries = g_hash_table_get_values (cache_entries);
+  entries = g_list_sort (entries, compare_last_used);
+
+  for (l = entries; l != NULL && cache_size > cache_max_size; l = l->next)
+    {
+      if (l->data != keep)
+        cache_remove_entry (l->data);
+    }
+
+  g_list_free (entries);
+
+  queue_save_index ();
+}
+
+/*
+ * twitter_image_cache_lookup:
+ * @url: the URL of an image
+ * @is_stale: return location for whether the image should be
+ *   revalidated
+ * @etag: return location for the ETag of the image, or %NULL
+ * @last_modified: return location for the modification date of
+ *   the image, or %NULL
+ *
+ * Looks up the image at @url in the cache, marking it as used.
+ *
+ * Return value: the path of the cached image, or %NULL
+ */
+gchar *
+twitter_image_cache_lookup (const gchar  *url,
+                            gboolean     *is_stale,
+                            gchar       **etag,
+                            gchar       **last_modified)
+{
+  CacheEntry *entry;
+  gchar *retval = NULL;
+  glong now;
+
+  g_return_val_if_fail (url != NULL, NULL);
+
+  G_LOCK (image_cache);
+
+  ensure_cache ();
+
+  entry = g_hash_table_lookup (cache_entries, url);
+  if (entry)
+    {
+      now = get_current_time ();
+
+      entry->last_used = now;
+      queue_save_index ();
+
+      if (is_stale)
+        *is_stale = (now - entry->validated) > REVALIDATE_INTERVAL;
+
+      if (etag)
+        *etag = g_strdup (entry->etag);
+
+      if (last_modified)
+        *last_modified = g_strdup (entry->last_modified);
+
+      retval = cache_entry_get_path (entry);
+    }
+
+  G_UNLOCK (image_cache);
+
+  return retval;
+}
+
+/*
+ * twitter_image_cache_revalidated:
+ * @url: the URL of a cached image
+ *
+ * Marks the image at @url as fresh, e.g. because the server
+ * told us it was not modified.
+ */
+void
+twitter_image_cache_revalidated (const gchar *url)
+{
+  CacheEntry *entry;
+
+  g_return_if_fail (url != NULL);
+
+  G_LOCK (image_cache);
+
+  ensure_cache ();
+
+  entry = g_hash_table_lookup (cache_entries, url);
+  if (entry)
+    {
+      entry->validated = get_current_time ();
+      queue_save_index ();
+    }
+
+  G_UNLOCK (image_cache);
+}
+
+/*
+ * twitter_image_cache_store:
+ * @url: the URL of the image
+ * @etag: the ETag of the image, or %NULL
+ * @last_modified: the modification date of the image, or %NULL
+ * @data: the contents of the image to store
+ * @length: the length of @data
+ *
+ * Stores @data as the cached copy of the image at @url, replacing
+ * the previous one, and makes room for it if needed. This function
+ * can be called from any thread.
+ */
+void
+twitter_image_cache_store (const gchar *url,
+                           const gchar *etag,
+                           const gchar *last_modified,
+                           const gchar *data,
+                           gsize        length)
+{
+  CacheEntry *entry;
+  gchar *path;
+  GError *error;
+
+  g_return_if_fail (url != NULL);
+  g_return_if_fail (data != NULL);
+
+  /* an image bigger than the whole cache would evict everything */
+  if (length > cache_max_size)
+    return;
+
+  G_LOCK (image_cache);
+
+  ensure_cache ();
+
+  if (g_mkdir_with_parents (cache_dir, 0700) == -1)
+    {
+      if (errno != EEXIST)
+        {
+          g_warning ("Unable to create the profile image cache: %s",
+                     g_strerror (errno));
+          G_UNLOCK (image_cache);
+          return;
+        }
+    }
+
+  entry = g_hash_table_lookup (cache_entries, url);
+  if (!entry)
+    {
+      entry = g_slice_new0 (CacheEntry);
+      entry->url = g_strdup (url);
+      entry->file = g_compute_checksum_for_string (G_CHECKSUM_SHA1, url, -1);
+
+      g_hash_table_insert (cache_entries, entry->url, entry);
+    }
+  else
+    cache_size -= entry->size;
+
+  path = cache_entry_get_path (entry);
+
+  error = NULL;
+  g_file_set_contents (path, data, length, &error);
+  if (error)
+    {
+      g_warning ("Unable to store the profile image for `%s': %s",
+                 url,
+                 error->message);
+      g_error_free (error);
+
+      /* the old file might have been replaced already */
+      g_unlink (path);
+      g_hash_table_remove (cache_entries, url);
+
+      queue_save_index ();
+
+      G_UNLOCK (image_cache);
+      g_free (path);
+
+      return;
+    }
+
+  g_free (path);
+
+  g_free (entry->etag);
+  g_free (entry->last_modified);
+
+  entry->etag = g_strdup (etag);
+  entry->last_modified = g_strdup (last_modified);
+  entry->size = length;
+  entry->last_used = entry->validated = get_current_time ();
+
+  cache_size += entry->size;
+
+  cache_evict (entry);
+  queue_save_index ();
+
+  G_UNLOCK (image_cache);
+}
+
+/*
+ * twitter_image_cache_set_max_size:
+ * @max_size: the maximum size of the cache, in bytes
+ *
+ * Sets the maximum size of the cache, removing the least recently
+ * used images if the cache is bigger than that.
+ */
+void
+twitter_image_cache_set_max_size (gsize max_size)
+{
+  G_LOCK (image_cache);
+
+  cache_max_size = max_size;
+
+  if (cache_entries)
+    cache_evict (NULL);
+
+  G_UNLOCK (image_cache);
+}
@@ -0,0 +1,41 @@
+/* twitter-image-cache.h: On-disk cache for the profile images
+ *
+ * This file is part of Twitter-GLib.
+ * Copyright (C) 2008  Emmanuele Bassi  <ebassi@gnome.org>
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __TWITTER_IMAGE_CACHE_H__
+#define __TWITTER_IMAGE_CACHE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+gchar *  twitter_image_cache_lookup       (const gchar  *url,
+                                           gboolean     *is_stale,
+                                           gchar       **etag,
+                                           gchar       **last_modified);
+void     twitter_image_cache_revalidated  (const gchar  *url);
+void     twitter_image_cache_store        (const gchar  *url,
+                                           const gchar  *etag,
+                                           const gchar  *last_modified,
+                                           const gchar  *data,
+                                           gsize         length);
+
+void     twitter_image_cache_set_max_size (gsize         max_size);
+
+G_END_DECLS
+
+#endif /* __TWITTER_IMAGE_CACHE_H__ */
@@ -0,0 +1,320 @@
+/* twitter-image-fetcher.c: Shared queue for image downloads
+ *
+ * This file is part of Twitter-GLib.
+ * Copyright (C) 2008  Emmanuele Bassi  <ebassi@gnome.org>
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Every profile image is downloaded through a single SoupSession, so
+ * that connections to the image hosts are kept alive and reused. The
+ * requests are kept inside two queues, one for the urgent requests
+ * (e.g. the images currently visible) and one for everything else,
+ * and are handed to the session only while the host they point to
+ * has less than max_conns_per_host requests in flight; this keeps
+ * the number of open sockets bounded no matter how many users we
+ * are showing.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "twitter-image-fetcher.h"
+
+#define DEFAULT_MAX_CONNS_PER_HOST      4
+
+struct _TwitterImageFetch
+{
+  gchar *url;
+  gchar *host;
+
+  /* the validators of a cached copy, if any */
+  gchar *etag;
+  gchar *last_modified;
+
+  TwitterImageFetchFunc func;
+  gpointer data;
+
+  /* the queue holding the fetch while it's pending */
+  GQueue *queue;
+
+  /* the message, while the fetch is in flight */
+  SoupMessage *msg;
+
+  guint cancelled : 1;
+};
+
+static SoupSession *fetcher_session = NULL;
+
+static GQueue urgent_queue = { NULL, NULL, 0 };
+static GQueue background_queue = { NULL, NULL, 0 };
+
+/* host name -> number of requests in flight */
+static GHashTable *active_hosts = NULL;
+
+static guint max_conns_per_host = DEFAULT_MAX_CONNS_PER_HOST;
+static TwitterQueuePolicy queue_policy = TWITTER_QUEUE_FIFO;
+
+static SoupSession *
+get_session (void)
+{
+  if (G_UNLIKELY (fetcher_session == NULL))
+    {
+      fetcher_session =
+        soup_session_async_new_with_options (SOUP_SESSION_MAX_CONNS_PER_HOST,
+                                             max_conns_per_host,
+                                             NULL);
+    }
+
+  return fetcher_session;
+}
+
+static guint
+host_get_active (const gchar *host)
+{
+  if (!active_hosts)
+    return 0;
+
+  return GPOINTER_TO_UINT (g_hash_table_lookup (active_hosts, host));
+}
+
+static void
+host_set_active (const gchar *host,
+                 guint        n_active)
+{
+  if (G_UNLIKELY (active_hosts == NULL))
+    active_hosts = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free,
+                                          NULL);
+
+  if (n_active == 0)
+    g_hash_table_remove (active_hosts, host);
+  else
+    g_hash_table_replace (active_hosts,
+                          g_strdup (host),
+                          GUINT_TO_POINTER (n_active));
+}
+
+static void
+twitter_image_fetch_free (TwitterImageFetch *fetch)
+{
+  g_free (fetch->url);
+  g_free (fetch->host);
+  g_free (fetch->etag);
+  g_free (fetch->last_modified);
+  g_free (fetch);
+}
+
+static void fetcher_dispatch (void);
+
+static void
+fetch_complete_cb (SoupSession *session,
+                   SoupMessage *msg,
+                   gpointer     user_data)
+{
+  TwitterImageFetch *fetch = user_data;
+
+  host_set_active (fetch->host, host_get_active (fetch->host) - 1);
+
+  if (!fetch->cancelled && fetch->func)
+    fetch->func (msg, fetch->data);
+
+  twitter_image_fetch_free (fetch);
+
+  fetcher_dispatch ();
+}
+
+static void
+fetch_start (TwitterImageFetch *fetch)
+{
+  fetch->queue = NULL;
+  fetch->msg = soup_message_new (SOUP_METHOD_GET, fetch->url);
+
+  /* the server will reply with 304 if our copy is still valid */
+  if (fetch->etag)
+    soup_message_headers_append (fetch->msg->request_headers,
+                                 "If-None-Match",
+                                 fetch->etag);
+
+  if (fetch->last_modified)
+    soup_message_headers_append (fetch->msg->request_headers,
+                                 "If-Modified-Since",
+                                 fetch->last_modified);
+
+  host_set_active (fetch->host, host_get_active (fetch->host) + 1);
+
+  soup_session_queue_message (get_session (), fetch->msg,
+                              fetch_complete_cb,
+                              fetch);
+}
+
+/* starts the first request of @queue, in the order defined by the
+ * queue policy, that points to a host which is not saturated yet
+ */
+static gboolean
+fetcher_start_from_queue (GQueue *queue)
+{
+  GList *l;
+
+  if (queue_policy == TWITTER_QUEUE_LIFO)
+    l = queue->tail;
+  else
+    l = queue->head;
+
+  while (l)
+    {
+      TwitterImageFetch *fetch = l->data;
+
+      if (host_get_active (fetch->host) < max_conns_per_host)
+        {
+          g_queue_delete_link (queue, l);
+          fetch_start (fetch);
+
+          return TRUE;
+        }
+
+      if (queue_policy == TWITTER_QUEUE_LIFO)
+        l = l->prev;
+      else
+        l = l->next;
+    }
+
+  return FALSE;
+}
+
+static void
+fetcher_dispatch (void)
+{
+  while (fetcher_start_from_queue (&urgent_queue) ||
+         fetcher_start_from_queue (&background_queue))
+    ;
+}
+
+/*
+ * twitter_image_fetcher_queue:
+ * @url: the URL of the image
+ * @etag: the ETag of a cached copy of the image, or %NULL
+ * @last_modified: the modification date of a cached copy of the
+ *   image, or %NULL
+ * @urgent: whether the image should be fetched before the
+ *   non urgent ones
+ * @func: function called when the download completes
+ * @data: data to pass to @func
+ *
+ * Queues the download of @url.
+ *
+ * Return value: a handle for the fetch, valid until @func is called
+ *   or the fetch is cancelled, or %NULL if @url is not valid
+ */
+TwitterImageFetch *
+twitter_image_fetcher_queue (const gchar           *url,
+                             const gchar           *etag,
+                             const gchar           *last_modified,
+                             gboolean               urgent,
+                             TwitterImageFetchFunc  func,
+                             gpointer               data)
+{
+  TwitterImageFetch *fetch;
+  SoupURI *uri;
+
+  g_return_val_if_fail (url != NULL, NULL);
+  g_return_val_if_fail (func != NULL, NULL);
+
+  uri = soup_uri_new (url);
+  if (!uri)
+    return NULL;
+
+  fetch = g_new0 (TwitterImageFetch, 1);
+  fetch->url = g_strdup (url);
+  fetch->host = g_strdup (uri->host ? uri->host : "");
+  fetch->etag = g_strdup (etag);
+  fetch->last_modified = g_strdup (last_modified);
+  fetch->func = func;
+  fetch->data = data;
+  fetch->queue = urgent ? &urgent_queue : &background_queue;
+
+  soup_uri_free (uri);
+
+  g_queue_push_tail (fetch->queue, fetch);
+
+  fetcher_dispatch ();
+
+  return fetch;
+}
+
+/*
+ * twitter_image_fetcher_promote:
+ * @fetch: a pending fetch
+ *
+ * Moves @fetch to the urgent queue, if it was not started yet.
+ */
+void
+twitter_image_fetcher_promote (TwitterImageFetch *fetch)
+{
+  g_return_if_fail (fetch != NULL);
+
+  if (fetch->queue != &background_queue)
+    return;
+
+  g_queue_remove (&background_queue, fetch);
+
+  fetch->queue = &urgent_queue;
+  g_queue_push_tail (fetch->queue, fetch);
+}
+
+/*
+ * twitter_image_fetcher_cancel:
+ * @fetch: a fetch
+ *
+ * Cancels @fetch; the function passed to twitter_image_fetcher_queue()
+ * will not be called, and @fetch will not be valid anymore.
+ */
+void
+twitter_image_fetcher_cancel (TwitterImageFetch *fetch)
+{
+  g_return_if_fail (fetch != NULL);
+
+  if (fetch->queue)
+    {
+      g_queue_remove (fetch->queue, fetch);
+      twitter_image_fetch_free (fetch);
+      return;
+    }
+
+  /* the completion callback will release the fetch */
+  fetch->cancelled = TRUE;
+  soup_session_cancel_message (get_session (), fetch->msg,
+                               SOUP_STATUS_CANCELLED);
+}
+
+void
+twitter_image_fetcher_set_limits (guint              conns_per_host,
+                                  TwitterQueuePolicy policy)
+{
+  g_return_if_fail (conns_per_host > 0);
+
+  max_conns_per_host = conns_per_host;
+  queue_policy = policy;
+
+  if (fetcher_session)
+    g_object_set (G_OBJECT (fetcher_session),
+                  SOUP_SESSION_MAX_CONNS_PER_HOST, max_conns_per_host,
+                  NULL);
+
+  fetcher_dispatch ();
+}
@@ -0,0 +1,56 @@
+/* twitter-image-fetcher.h: Shared queue for image downloads
+ *
+ * This file is part of Twitter-GLib.
+ * Copyright (C) 2008  Emmanuele Bassi  <ebassi@gnome.org>
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __TWITTER_IMAGE_FETCHER_H__
+#define __TWITTER_IMAGE_FETCHER_H__
+
+#include <glib.h>
+#include <libsoup/soup.h>
+
+#include "twitter-common.h"
+
+G_BEGIN_DECLS
+
+typedef struct _TwitterImageFetch       TwitterImageFetch;
+
+/*
+ * TwitterImageFetchFunc:
+ * @msg: the #SoupMessage used for the download
+ * @data: data passed to twitter_image_fetcher_queue()
+ *
+ * Called when a download completes, successfully or not; it is never
+ * called for a fetch that was cancelled.
+ */
+typedef void (* TwitterImageFetchFunc) (SoupMessage *msg,
+                                        gpointer     data);
+
+TwitterImageFetch *twitter_image_fetcher_queue      (const gchar           *url,
+                                                     const gchar           *etag,
+                                                     const gchar           *last_modified,
+                                                     gboolean               urgent,
+                                                     TwitterImageFetchFunc  func,
+                                                     gpointer               data);
+void               twitter_image_fetcher_promote    (TwitterImageFetch     *fetch);
+void               twitter_image_fetcher_cancel     (TwitterImageFetch     *fetch);
+
+void               twitter_image_fetcher_set_limits (guint                  max_conns_per_host,
+                                                     TwitterQueuePolicy     policy);
+
+G_END_DECLS
+
+#endif /* __TWITTER_IMAGE_FETCHER_H__ */
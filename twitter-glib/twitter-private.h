@@ -21,7 +21,9 @@
 
 #include <json-glib/json-glib.h>
 #include "twitter-status.h"
+#include "twitter-timeline.h"
 #include "twitter-user.h"
+#include "twitter-user-list.h"
 
 G_BEGIN_DECLS
 
@@ -30,6 +32,22 @@ G_BEGIN_DECLS
 TwitterStatus *twitter_status_new_from_node (JsonNode *node);
 TwitterUser   *twitter_user_new_from_node   (JsonNode *node);
 
+/* user registry, mapping ids to live TwitterUser instances */
+GHashTable    *twitter_user_registry_new     (void);
+void           twitter_user_registry_destroy (GHashTable  *registry);
+TwitterUser   *twitter_user_registry_intern  (GHashTable  *registry,
+                                              TwitterUser *user);
+
+void           twitter_status_intern_user     (TwitterStatus   *status,
+                                               GHashTable      *registry);
+void           twitter_timeline_intern_users  (TwitterTimeline *timeline,
+                                               GHashTable      *registry);
+void           twitter_user_list_intern_users (TwitterUserList *user_list,
+                                               GHashTable      *registry);
+
+gboolean       twitter_timeline_add_status    (TwitterTimeline *timeline,
+                                               TwitterStatus   *status);
+
 G_END_DECLS
 
 #endif /* __TWITTER_PRIVATE_H__ */
@@ -234,13 +234,20 @@ twitter_status_clean (TwitterStatus *status)
   TwitterStatusPrivate *priv = status->priv;
 
   g_free (priv->source);
+  priv->source = NULL;
+
   g_free (priv->created_at);
+  priv->created_at = NULL;
+
   g_free (priv->text);
+  priv->text = NULL;
 
   if (priv->user)
     {
       g_signal_handler_disconnect (priv->user, priv->user_changed_id);
       g_object_unref (priv->user);
+      priv->user = NULL;
+      priv->user_changed_id = 0;
     }
 }
 
@@ -347,6 +354,14 @@ twitter_status_new_from_node (JsonNode *node)
 void
 twitter_status_load_from_data (TwitterStatus *status,
                                const gchar   *buffer)
+{
+  twitter_status_load_from_buffer (status, buffer, -1);
+}
+
+void
+twitter_status_load_from_buffer (TwitterStatus *status,
+                                 const gchar   *buffer,
+                                 gssize         length)
 {
   JsonParser *parser;
   GError *parse_error;
@@ -358,7 +373,7 @@ twitter_status_load_from_data (TwitterStatus *status,
 
   parser = json_parser_new ();
   parse_error = NULL;
-  json_parser_load_from_data (parser, buffer, -1, &parse_error);
+  json_parser_load_from_data (parser, buffer, length, &parse_error);
   if (parse_error)
     {
       g_warning ("Unable to parse data into a status: %s",
@@ -371,6 +386,43 @@ twitter_status_load_from_data (TwitterStatus *status,
   g_object_unref (parser);
 }
 
+/*
+ * twitter_status_intern_user:
+ * @status: a #TwitterStatus
+ * @registry: a user registry
+ *
+ * Replaces the user of @status with the canonical instance held
+ * by @registry, so that every status written by the same user
+ * shares a single #TwitterUser.
+ */
+void
+twitter_status_intern_user (TwitterStatus *status,
+                            GHashTable    *registry)
+{
+  TwitterStatusPrivate *priv;
+  TwitterUser *user;
+
+  g_return_if_fail (TWITTER_IS_STATUS (status));
+  g_return_if_fail (registry != NULL);
+
+  priv = status->priv;
+
+  if (!priv->user)
+    return;
+
+  user = twitter_user_registry_intern (registry, priv->user);
+  if (user == priv->user)
+    return;
+
+  g_signal_handler_disconnect (priv->user, priv->user_changed_id);
+  g_object_unref (priv->user);
+
+  priv->user = g_object_ref (user);
+  priv->user_changed_id = g_signal_connect (priv->user, "changed",
+                                            G_CALLBACK (user_changed_cb),
+                                            status);
+}
+
 TwitterUser *
 twitter_status_get_user (TwitterStatus *status)
 {
@@ -33,6 +33,9 @@ TwitterStatus *       twitter_status_new_from_data       (const gchar   *buffer)
 
 void                  twitter_status_load_from_data      (TwitterStatus *status,
                                                           const gchar   *buffer);
+void                  twitter_status_load_from_buffer    (TwitterStatus *status,
+                                                          const gchar   *buffer,
+                                                          gssize         length);
 
 TwitterUser *         twitter_status_get_user            (TwitterStatus *status);
 G_CONST_RETURN gchar *twitter_status_get_source          (TwitterStatus *status);
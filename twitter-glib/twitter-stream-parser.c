@@ -0,0 +1,342 @@
+/* twitter-stream-parser.c: Incremental parser for JSON arrays
+ *
+ * This file is part of Twitter-GLib.
+ * Copyright (C) 2008  Emmanuele Bassi  <ebassi@gnome.org>
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The Twitter API returns timelines as a single JSON array, which
+ * means that JsonParser can only build it once the whole body has
+ * been received. The stream parser is fed with the chunks of the
+ * body as they arrive, and scans them just enough to find where each
+ * element of the top-level array starts and ends, keeping track of
+ * the nesting level and of the string literals; every complete
+ * element is then handed to a JsonParser on its own, so that only
+ * one element at a time is kept in memory.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "twitter-stream-parser.h"
+
+typedef enum {
+  STREAM_STATE_START,   /* before the opening '[' */
+  STREAM_STATE_ARRAY,   /* inside the top-level array */
+  STREAM_STATE_END,     /* after the closing ']' */
+  STREAM_STATE_ERROR
+} StreamState;
+
+struct _TwitterStreamParser
+{
+  StreamState state;
+
+  /* nesting level inside the current element */
+  guint depth;
+
+  guint in_element : 1;
+  guint in_string  : 1;
+  guint in_escape  : 1;
+
+  /* whether the last thing seen at the top level was an element
+   * or a separator, so that empty elements can be rejected
+   */
+  guint after_element   : 1;
+  guint after_separator : 1;
+
+  /* the data of the current element */
+  GString *element;
+
+  JsonParser *parser;
+
+  TwitterStreamElementFunc func;
+  gpointer data;
+};
+
+#define is_space(c)     ((c) == ' ' || (c) == '\t' || (c) == '\n' || (c) == '\r')
+
+TwitterStreamParser *
+twitter_stream_parser_new (TwitterStreamElementFunc func,
+                           gpointer                 data)
+{
+  TwitterStreamParser *parser;
+
+  g_return_val_if_fail (func != NULL, NULL);
+
+  parser = g_new0 (TwitterStreamParser, 1);
+  parser->state = STREAM_STATE_START;
+  parser->element = g_string_sized_new (1024);
+  parser->parser = json_parser_new ();
+  parser->func = func;
+  parser->data = data;
+
+  return parser;
+}
+
+void
+twitter_stream_parser_free (TwitterStreamParser *parser)
+{
+  if (!parser)
+    return;
+
+  g_string_free (parser->element, TRUE);
+  g_object_unref (parser->parser);
+
+  g_free (parser);
+}
+
+static gboolean
+stream_parser_set_error (TwitterStreamParser  *parser,
+                         GError              **error,
+                         const gchar          *message)
+{
+  parser->state = STREAM_STATE_ERROR;
+
+  g_set_error (error, JSON_PARSER_ERROR,
+               JSON_PARSER_ERROR_PARSE,
+               "%s", message);
+
+  return FALSE;
+}
+
+/* marks the start of a top-level element, unless we are already
+ * inside one
+ */
+static gboolean
+stream_parser_begin_element (TwitterStreamParser  *parser,
+                             GError              **error)
+{
+  if (parser->in_element)
+    return TRUE;
+
+  if (parser->after_element)
+    return stream_parser_set_error (parser, error,
+                                    "Missing separator between elements");
+
+  parser->in_element = TRUE;
+  parser->after_element = TRUE;
+  parser->after_separator = FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+stream_parser_emit_element (TwitterStreamParser  *parser,
+                            GError              **error)
+{
+  GError *parse_error = NULL;
+
+  parser->in_element = FALSE;
+
+  json_parser_load_from_data (parser->parser,
+                              parser->element->str,
+                              parser->element->len,
+                              &parse_error);
+
+  /* keep the allocated space around for the next element */
+  g_string_truncate (parser->element, 0);
+
+  if (parse_error)
+    {
+      parser->state = STREAM_STATE_ERROR;
+      g_propagate_error (error, parse_error);
+      return FALSE;
+    }
+
+  parser->func (json_parser_get_root (parser->parser), parser->data);
+
+  return TRUE;
+}
+
+/*
+ * twitter_stream_parser_feed:
+ * @parser: a #TwitterStreamParser
+ * @buffer: a chunk of data
+ * @length: the length of @buffer
+ * @error: return location for a #GError, or %NULL
+ *
+ * Feeds @buffer to @parser; the element function will be called for
+ * each element of the top-level array completed by @buffer.
+ *
+ * Return value: %FALSE if the data is not a valid JSON array
+ */
+gboolean
+twitter_stream_parser_feed (TwitterStreamParser  *parser,
+                            const gchar          *buffer,
+                            gsize                 length,
+                            GError              **error)
+{
+  const gchar *p, *end;
+
+  g_return_val_if_fail (parser != NULL, FALSE);
+
+  if (parser->state == STREAM_STATE_ERROR)
+    return FALSE;
+
+  for (p = buffer, end = buffer + length; p < end; p++)
+    {
+      gchar c = *p;
+
+      if (parser->state == STREAM_STATE_START)
+        {
+          if (is_space (c))
+            continue;
+
+          if (c != '[')
+            return stream_parser_set_error (parser, error,
+                                            "Expected an array");
+
+          parser->state = STREAM_STATE_ARRAY;
+          continue;
+        }
+
+      if (parser->state == STREAM_STATE_END)
+        {
+          if (is_space (c))
+            continue;
+
+          return stream_parser_set_error (parser, error,
+                                          "Trailing data after the array");
+        }
+
+      if (parser->in_string)
+        {
+          g_string_append_c (parser->element, c);
+
+          if (parser->in_escape)
+            parser->in_escape = FALSE;
+          else if (c == '\\')
+            parser->in_escape = TRUE;
+          else if (c == '"')
+            parser->in_string = FALSE;
+
+          continue;
+        }
+
+      switch (c)
+        {
+        case '"':
+          if (!stream_parser_begin_element (parser, error))
+            return FALSE;
+
+          parser->in_string = TRUE;
+          g_string_append_c (parser->element, c);
+          break;
+
+        case '{':
+        case '[':
+          if (!stream_parser_begin_element (parser, error))
+            return FALSE;
+
+          parser->depth += 1;
+          g_string_append_c (parser->element, c);
+          break;
+
+        case '}':
+        case ']':
+          if (parser->depth == 0)
+            {
+              if (c != ']')
+                return stream_parser_set_error (parser, error,
+                                                "Unbalanced braces");
+
+              /* end of the top-level array; a scalar element
+               * might still be pending
+               */
+              if (parser->in_element &&
+                  !stream_parser_emit_element (parser, error))
+                return FALSE;
+
+              if (parser->after_separator)
+                return stream_parser_set_error (parser, error,
+                                                "Empty element in the array");
+
+              parser->state = STREAM_STATE_END;
+              break;
+            }
+
+          g_string_append_c (parser->element, c);
+
+          parser->depth -= 1;
+          if (parser->depth == 0 &&
+              !stream_parser_emit_element (parser, error))
+            return FALSE;
+          break;
+
+        case ',':
+          if (parser->depth == 0)
+            {
+              if (parser->in_element &&
+                  !stream_parser_emit_element (parser, error))
+                return FALSE;
+
+              if (!parser->after_element)
+                return stream_parser_set_error (parser, error,
+                                                "Empty element in the array");
+
+              parser->after_element = FALSE;
+              parser->after_separator = TRUE;
+            }
+          else
+            g_string_append_c (parser->element, c);
+          break;
+
+        default:
+          if (is_space (c) && !parser->in_element)
+            break;
+
+          if (!stream_parser_begin_element (parser, error))
+            return FALSE;
+
+          g_string_append_c (parser->element, c);
+          break;
+        }
+    }
+
+  return TRUE;
+}
+
+/*
+ * twitter_stream_parser_finish:
+ * @parser: a #TwitterStreamParser
+ * @error: return location for a #GError, or %NULL
+ *
+ * Checks that the data fed to @parser was a complete JSON array.
+ *
+ * Return value: %TRUE if the whole array was parsed
+ */
+gboolean
+twitter_stream_parser_finish (TwitterStreamParser  *parser,
+                              GError              **error)
+{
+  g_return_val_if_fail (parser != NULL, FALSE);
+
+  switch (parser->state)
+    {
+    case STREAM_STATE_END:
+      return TRUE;
+
+    case STREAM_STATE_ERROR:
+      return FALSE;
+
+    default:
+      return stream_parser_set_error (parser, error,
+                                      "Unexpected end of the data");
+    }
+}
@@ -0,0 +1,53 @@
+/* twitter-stream-parser.h: Incremental parser for JSON arrays
+ *
+ * This file is part of Twitter-GLib.
+ * Copyright (C) 2008  Emmanuele Bassi  <ebassi@gnome.org>
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef __TWITTER_STREAM_PARSER_H__
+#define __TWITTER_STREAM_PARSER_H__
+
+#include <glib.h>
+#include <json-glib/json-glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _TwitterStreamParser     TwitterStreamParser;
+
+/*
+ * TwitterStreamElementFunc:
+ * @element: the parsed element of the array
+ * @data: data passed to twitter_stream_parser_new()
+ *
+ * Called each time an element of the top-level array has been
+ * completely received and parsed. @element is owned by the parser
+ * and it is valid only for the duration of the call.
+ */
+typedef void (* TwitterStreamElementFunc) (JsonNode *element,
+                                           gpointer  data);
+
+TwitterStreamParser *twitter_stream_parser_new    (TwitterStreamElementFunc   func,
+                                                   gpointer                   data);
+void                 twitter_stream_parser_free   (TwitterStreamParser       *parser);
+gboolean             twitter_stream_parser_feed   (TwitterStreamParser       *parser,
+                                                   const gchar               *buffer,
+                                                   gsize                      length,
+                                                   GError                   **error);
+gboolean             twitter_stream_parser_finish (TwitterStreamParser       *parser,
+                                                   GError                   **error);
+
+G_END_DECLS
+
+#endif /* __TWITTER_STREAM_PARSER_H__ */
@@ -174,6 +174,14 @@ twitter_timeline_new_from_data (const gchar *buffer)
 void
 twitter_timeline_load_from_data (TwitterTimeline *timeline,
                                  const gchar     *buffer)
+{
+  twitter_timeline_load_from_buffer (timeline, buffer, -1);
+}
+
+void
+twitter_timeline_load_from_buffer (TwitterTimeline *timeline,
+                                   const gchar     *buffer,
+                                   gssize           length)
 {
   JsonParser *parser;
   GError *parse_error;
@@ -185,7 +193,7 @@ twitter_timeline_load_from_data (TwitterTimeline *timeline,
 
   parser = json_parser_new ();
   parse_error = NULL;
-  json_parser_load_from_data (parser, buffer, -1, &parse_error);
+  json_parser_load_from_data (parser, buffer, length, &parse_error);
   if (parse_error)
     {
       g_warning ("Unable to parse data into a timeline: %s",
@@ -198,6 +206,50 @@ twitter_timeline_load_from_data (TwitterTimeline *timeline,
   g_object_unref (parser);
 }
 
+void
+twitter_timeline_intern_users (TwitterTimeline *timeline,
+                               GHashTable      *registry)
+{
+  GList *l;
+
+  g_return_if_fail (TWITTER_IS_TIMELINE (timeline));
+  g_return_if_fail (registry != NULL);
+
+  for (l = timeline->priv->status_list; l != NULL; l = l->next)
+    twitter_status_intern_user (l->data, registry);
+}
+
+/* adds a status received incrementally; statuses are received from
+ * the newest to the oldest, so this keeps the same ordering used by
+ * twitter_timeline_build()
+ */
+gboolean
+twitter_timeline_add_status (TwitterTimeline *timeline,
+                             TwitterStatus   *status)
+{
+  TwitterTimelinePrivate *priv;
+  guint status_id;
+
+  g_return_val_if_fail (TWITTER_IS_TIMELINE (timeline), FALSE);
+  g_return_val_if_fail (TWITTER_IS_STATUS (status), FALSE);
+
+  priv = timeline->priv;
+
+  status_id = twitter_status_get_id (status);
+  if (status_id == 0)
+    return FALSE;
+
+  if (g_hash_table_lookup (priv->status_by_id, GUINT_TO_POINTER (status_id)))
+    return FALSE;
+
+  g_hash_table_insert (priv->status_by_id,
+                       GUINT_TO_POINTER (status_id),
+                       g_object_ref_sink (status));
+  priv->status_list = g_list_prepend (priv->status_list, status);
+
+  return TRUE;
+}
+
 guint
 twitter_timeline_get_count (TwitterTimeline *timeline)
 {
@@ -54,6 +54,9 @@ TwitterTimeline *twitter_timeline_new_from_data  (const gchar     *buffer);
 
 void             twitter_timeline_load_from_data (TwitterTimeline *timeline,
                                                   const gchar     *buffer);
+void             twitter_timeline_load_from_buffer (TwitterTimeline *timeline,
+                                                    const gchar     *buffer,
+                                                    gssize           length);
 
 guint            twitter_timeline_get_count      (TwitterTimeline *timeline);
 TwitterStatus *  twitter_timeline_get_id         (TwitterTimeline *timeline,
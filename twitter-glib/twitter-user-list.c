@@ -173,7 +173,15 @@ twitter_user_list_new_from_data (const gchar *buffer)
 
 void
 twitter_user_list_load_from_data (TwitterUserList *user_list,
-                                 const gchar     *buffer)
+                                  const gchar     *buffer)
+{
+  twitter_user_list_load_from_buffer (user_list, buffer, -1);
+}
+
+void
+twitter_user_list_load_from_buffer (TwitterUserList *user_list,
+                                    const gchar     *buffer,
+                                    gssize           length)
 {
   JsonParser *parser;
   GError *parse_error;
@@ -185,7 +193,7 @@ twitter_user_list_load_from_data (TwitterUserList *user_list,
 
   parser = json_parser_new ();
   parse_error = NULL;
-  json_parser_load_from_data (parser, buffer, -1, &parse_error);
+  json_parser_load_from_data (parser, buffer, length, &parse_error);
   if (parse_error)
     {
       g_warning ("Unable to parse data into a user list: %s",
@@ -198,6 +206,35 @@ twitter_user_list_load_from_data (TwitterUserList *user_list,
   g_object_unref (parser);
 }
 
+void
+twitter_user_list_intern_users (TwitterUserList *user_list,
+                                GHashTable      *registry)
+{
+  TwitterUserListPrivate *priv;
+  GList *l;
+
+  g_return_if_fail (TWITTER_IS_USER_LIST (user_list));
+  g_return_if_fail (registry != NULL);
+
+  priv = user_list->priv;
+
+  for (l = priv->user_list; l != NULL; l = l->next)
+    {
+      TwitterUser *user = l->data;
+      TwitterUser *canonical;
+
+      canonical = twitter_user_registry_intern (registry, user);
+      if (canonical == user)
+        continue;
+
+      /* the hash table owns the reference on the list items */
+      l->data = canonical;
+      g_hash_table_replace (priv->user_by_id,
+                            GUINT_TO_POINTER (twitter_user_get_id (canonical)),
+                            g_object_ref (canonical));
+    }
+}
+
 guint
 twitter_user_list_get_count (TwitterUserList *user_list)
 {
@@ -54,6 +54,9 @@ TwitterUserList *twitter_user_list_new_from_data  (const gchar     *buffer);
 
 void             twitter_user_list_load_from_data (TwitterUserList *user_list,
                                                    const gchar     *buffer);
+void             twitter_user_list_load_from_buffer (TwitterUserList *user_list,
+                                                     const gchar     *buffer,
+                                                     gssize           length);
 
 guint            twitter_user_list_get_count      (TwitterUserList *user_list);
 TwitterUser   *  twitter_user_list_get_id         (TwitterUserList *user_list,
@@ -23,8 +23,6 @@
 #include <string.h>
 #include <stdlib.h>
 
-#include <errno.h>
-
 #include <gio/gio.h>
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
@@ -32,6 +30,8 @@
 #include <libsoup/soup.h>
 
 #include "twitter-common.h"
+#include "twitter-image-cache.h"
+#include "twitter-image-fetcher.h"
 #include "twitter-marshal.h"
 #include "twitter-private.h"
 #include "twitter-user.h"
@@ -66,7 +66,39 @@ struct _TwitterUserPrivate
 
   guint profile_image_load : 1;
 
-  SoupSession *async_session;
+  /* set if someone asked for the profile image without giving us
+   * an object to track; the download cannot be cancelled
+   */
+  guint profile_image_pinned : 1;
+
+  TwitterImageFetch *profile_image_fetch;
+
+  /* the objects waiting for the profile image */
+  GSList *profile_image_requesters;
+
+  /* the members found in the JSON object we were built from */
+  guint fields;
+};
+
+enum
+{
+  FIELD_NAME              = 1 << 0,
+  FIELD_URL               = 1 << 1,
+  FIELD_DESCRIPTION       = 1 << 2,
+  FIELD_LOCATION          = 1 << 3,
+  FIELD_SCREEN_NAME       = 1 << 4,
+  FIELD_PROFILE_IMAGE_URL = 1 << 5,
+  FIELD_ID                = 1 << 6,
+  FIELD_PROTECTED         = 1 << 7,
+  FIELD_STATUS            = 1 << 8,
+  FIELD_FOLLOWING         = 1 << 9,
+  FIELD_FRIENDS_COUNT     = 1 << 10,
+  FIELD_STATUSES_COUNT    = 1 << 11,
+  FIELD_FOLLOWERS_COUNT   = 1 << 12,
+  FIELD_FAVORITES_COUNT   = 1 << 13,
+  FIELD_CREATED_AT        = 1 << 14,
+  FIELD_TIME_ZONE         = 1 << 15,
+  FIELD_UTC_OFFSET        = 1 << 16
 };
 
 enum
@@ -103,6 +135,24 @@ static guint user_signals[LAST_SIGNAL] = { 0, };
 
 G_DEFINE_TYPE (TwitterUser, twitter_user, G_TYPE_INITIALLY_UNOWNED);
 
+static void requester_weak_notify (gpointer  data,
+                                   GObject  *where_the_object_was);
+
+static void
+twitter_user_clear_requesters (TwitterUser *user)
+{
+  TwitterUserPrivate *priv = user->priv;
+  GSList *l;
+
+  for (l = priv->profile_image_requesters; l != NULL; l = l->next)
+    g_object_weak_unref (l->data, requester_weak_notify, user);
+
+  g_slist_free (priv->profile_image_requesters);
+  priv->profile_image_requesters = NULL;
+
+  priv->profile_image_pinned = FALSE;
+}
+
 static void
 twitter_user_finalize (GObject *gobject)
 {
@@ -137,14 +187,9 @@ twitter_user_dispose (GObject *gobject)
       priv->profile_image = NULL;
     }
 
-  if (priv->async_session)
-    {
-      soup_session_abort (priv->async_session);
-      g_object_unref (priv->async_session);
-      priv->async_session = NULL;
-    }
+  twitter_user_clear_requesters (TWITTER_USER (gobject));
 
-  G_OBJECT_CLASS (twitter_user_parent_class)->finalize (gobject);
+  G_OBJECT_CLASS (twitter_user_parent_class)->dispose (gobject);
 }
 
 static void
@@ -380,16 +425,36 @@ twitter_user_clean (TwitterUser *user)
   TwitterUserPrivate *priv = user->priv;
 
   g_free (priv->name);
+  priv->name = NULL;
+
   g_free (priv->url);
+  priv->url = NULL;
+
   g_free (priv->description);
+  priv->description = NULL;
+
   g_free (priv->location);
+  priv->location = NULL;
+
   g_free (priv->screen_name);
+  priv->screen_name = NULL;
+
   g_free (priv->profile_image_url);
+  priv->profile_image_url = NULL;
+
   g_free (priv->created_at);
+  priv->created_at = NULL;
+
   g_free (priv->time_zone);
+  priv->time_zone = NULL;
 
   if (priv->status)
-    g_object_unref (priv->status);
+    {
+      g_object_unref (priv->status);
+      priv->status = NULL;
+    }
+
+  priv->fields = 0;
 }
 
 static void
@@ -407,75 +472,124 @@ twitter_user_build (TwitterUser *user,
 
   member = json_object_get_member (obj, "name");
   if (member)
-    priv->name = json_node_dup_string (member);
+    {
+      priv->name = json_node_dup_string (member);
+      priv->fields |= FIELD_NAME;
+    }
 
   member = json_object_get_member (obj, "url");
   if (member)
-    priv->url = json_node_dup_string (member);
+    {
+      priv->url = json_node_dup_string (member);
+      priv->fields |= FIELD_URL;
+    }
 
   member = json_object_get_member (obj, "description");
   if (member)
-    priv->description = json_node_dup_string (member);
+    {
+      priv->description = json_node_dup_string (member);
+      priv->fields |= FIELD_DESCRIPTION;
+    }
 
   member = json_object_get_member (obj, "location");
   if (member)
-    priv->location = json_node_dup_string (member);
-    
+    {
+      priv->location = json_node_dup_string (member);
+      priv->fields |= FIELD_LOCATION;
+    }
+
   member = json_object_get_member (obj, "screen_name");
   if (member)
-    priv->screen_name = json_node_dup_string (member);
+    {
+      priv->screen_name = json_node_dup_string (member);
+      priv->fields |= FIELD_SCREEN_NAME;
+    }
 
   member = json_object_get_member (obj, "profile_image_url");
   if (member)
-    priv->profile_image_url = json_node_dup_string (member);
+    {
+      priv->profile_image_url = json_node_dup_string (member);
+      priv->fields |= FIELD_PROFILE_IMAGE_URL;
+    }
 
   member = json_object_get_member (obj, "id");
   if (member)
-    priv->id = json_node_get_int (member);
+    {
+      priv->id = json_node_get_int (member);
+      priv->fields |= FIELD_ID;
+    }
 
   member = json_object_get_member (obj, "protected");
   if (member)
-    priv->protected = json_node_get_boolean (member);
+    {
+      priv->protected = json_node_get_boolean (member);
+      priv->fields |= FIELD_PROTECTED;
+    }
 
   member = json_object_get_member (obj, "status");
   if (member)
     {
       priv->status = twitter_status_new_from_node (member);
       g_object_ref_sink (priv->status);
+      priv->fields |= FIELD_STATUS;
     }
 
   member = json_object_get_member (obj, "following");
   if (member)
-    priv->following = json_node_get_boolean (member);
+    {
+      priv->following = json_node_get_boolean (member);
+      priv->fields |= FIELD_FOLLOWING;
+    }
 
   member = json_object_get_member (obj, "friends_count");
   if (member)
-    priv->friends_count = json_node_get_int (member);
+    {
+      priv->friends_count = json_node_get_int (member);
+      priv->fields |= FIELD_FRIENDS_COUNT;
+    }
 
   member = json_object_get_member (obj, "statuses_count");
   if (member)
-    priv->statuses_count = json_node_get_int (member);
+    {
+      priv->statuses_count = json_node_get_int (member);
+      priv->fields |= FIELD_STATUSES_COUNT;
+    }
 
   member = json_object_get_member (obj, "followers_count");
   if (member)
-    priv->followers_count = json_node_get_int (member);
+    {
+      priv->followers_count = json_node_get_int (member);
+      priv->fields |= FIELD_FOLLOWERS_COUNT;
+    }
 
   /* XXX - english spelling */
   member = json_object_get_member (obj, "favourites_count");
   if (member)
-    priv->favorites_count = json_node_get_int (member);
+    {
+      priv->favorites_count = json_node_get_int (member);
+      priv->fields |= FIELD_FAVORITES_COUNT;
+    }
 
   member = json_object_get_member (obj, "created_at");
   if (member)
-    priv->created_at = json_node_dup_string (member);
+    {
+      priv->created_at = json_node_dup_string (member);
+      priv->fields |= FIELD_CREATED_AT;
+    }
 
   member = json_object_get_member (obj, "time_zone");
   if (member)
-    priv->time_zone = json_node_dup_string (member);
+    {
+      priv->time_zone = json_node_dup_string (member);
+      priv->fields |= FIELD_TIME_ZONE;
+    }
 
   member = json_object_get_member (obj, "utc_offset");
   if (member)
-    priv->utc_offset = json_node_get_int (member);
+    {
+      priv->utc_offset = json_node_get_int (member);
+      priv->fields |= FIELD_UTC_OFFSET;
+    }
 }
 
 TwitterUser *
@@ -528,6 +642,14 @@ twitter_user_new_from_data (const gchar *buffer)
 void
 twitter_user_load_from_data (TwitterUser *user,
                              const gchar *buffer)
+{
+  twitter_user_load_from_buffer (user, buffer, -1);
+}
+
+void
+twitter_user_load_from_buffer (TwitterUser *user,
+                               const gchar *buffer,
+                               gssize       length)
 {
   JsonParser *parser;
   GError *parse_error;
@@ -539,7 +661,7 @@ twitter_user_load_from_data (TwitterUser *user,
 
   parser = json_parser_new ();
   parse_error = NULL;
-  json_parser_load_from_data (parser, buffer, -1, &parse_error);
+  json_parser_load_from_data (parser, buffer, length, &parse_error);
   if (parse_error)
     {
       g_warning ("Unable to parse data into a user: %s",
@@ -552,6 +674,199 @@ twitter_user_load_from_data (TwitterUser *user,
   g_object_unref (parser);
 }
 
+#define merge_string(field,flag)        G_STMT_START {                  \
+  if ((other_priv->fields & (flag)) &&                                  \
+      g_strcmp0 (priv->field, other_priv->field) != 0)                  \
+    {                                                                   \
+      g_free (priv->field);                                             \
+      priv->field = g_strdup (other_priv->field);                       \
+      changed = TRUE;                                                   \
+    }                                                                   } G_STMT_END
+
+#define merge_value(field,flag)         G_STMT_START {                  \
+  if ((other_priv->fields & (flag)) &&                                  \
+      priv->field != other_priv->field)                                 \
+    {                                                                   \
+      priv->field = other_priv->field;                                  \
+      changed = TRUE;                                                   \
+    }                                                                   } G_STMT_END
+
+/*
+ * twitter_user_merge:
+ * @user: a #TwitterUser
+ * @other: a #TwitterUser with the same id
+ *
+ * Copies into @user every member of @other that was present in the
+ * JSON payload @other was built from and that differs from the
+ * current value; the #TwitterUser::changed signal is emitted on
+ * @user only if something actually changed.
+ *
+ * Return value: %TRUE if @user was changed
+ */
+static gboolean
+twitter_user_merge (TwitterUser *user,
+                    TwitterUser *other)
+{
+  TwitterUserPrivate *priv = user->priv;
+  TwitterUserPrivate *other_priv = other->priv;
+  gboolean changed = FALSE;
+
+  merge_string (name, FIELD_NAME);
+  merge_string (url, FIELD_URL);
+  merge_string (description, FIELD_DESCRIPTION);
+  merge_string (location, FIELD_LOCATION);
+  merge_string (screen_name, FIELD_SCREEN_NAME);
+  merge_string (created_at, FIELD_CREATED_AT);
+  merge_string (time_zone, FIELD_TIME_ZONE);
+
+  merge_value (protected, FIELD_PROTECTED);
+  merge_value (following, FIELD_FOLLOWING);
+  merge_value (friends_count, FIELD_FRIENDS_COUNT);
+  merge_value (statuses_count, FIELD_STATUSES_COUNT);
+  merge_value (followers_count, FIELD_FOLLOWERS_COUNT);
+  merge_value (favorites_count, FIELD_FAVORITES_COUNT);
+  merge_value (utc_offset, FIELD_UTC_OFFSET);
+
+  if ((other_priv->fields & FIELD_PROFILE_IMAGE_URL) &&
+      g_strcmp0 (priv->profile_image_url, other_priv->profile_image_url) != 0)
+    {
+      g_free (priv->profile_image_url);
+      priv->profile_image_url = g_strdup (other_priv->profile_image_url);
+
+      /* the avatar changed, so drop the one we have, as well as the
+       * one we might be loading; the next call to
+       * twitter_user_get_profile_image() will fetch the new one
+       */
+      if (priv->profile_image)
+        {
+          g_object_unref (priv->profile_image);
+          priv->profile_image = NULL;
+        }
+
+      if (priv->profile_image_fetch)
+        {
+          twitter_image_fetcher_cancel (priv->profile_image_fetch);
+          priv->profile_image_fetch = NULL;
+
+          g_object_unref (user);
+        }
+
+      priv->profile_image_load = FALSE;
+
+      changed = TRUE;
+    }
+
+  if ((other_priv->fields & FIELD_STATUS) && other_priv->status &&
+      (!priv->status ||
+       twitter_status_get_id (priv->status) !=
+       twitter_status_get_id (other_priv->status)))
+    {
+      if (priv->status)
+        g_object_unref (priv->status);
+
+      priv->status = g_object_ref (other_priv->status);
+
+      changed = TRUE;
+    }
+
+  priv->fields |= other_priv->fields;
+
+  if (changed)
+    g_signal_emit (user, user_signals[CHANGED], 0);
+
+  return changed;
+}
+
+#undef merge_string
+#undef merge_value
+
+static void
+registry_weak_notify (gpointer  data,
+                      GObject  *where_the_object_was)
+{
+  GHashTable *registry = data;
+  TwitterUser *user = (TwitterUser *) where_the_object_was;
+  gpointer key = GUINT_TO_POINTER (user->priv->id);
+
+  if (g_hash_table_lookup (registry, key) == user)
+    g_hash_table_remove (registry, key);
+}
+
+static void
+registry_unref_user (gpointer key,
+                     gpointer value,
+                     gpointer data)
+{
+  g_object_weak_unref (value, registry_weak_notify, data);
+}
+
+/*
+ * twitter_user_registry_new:
+ *
+ * Creates a new user registry, mapping user ids to the #TwitterUser
+ * instances currently alive. The registry does not hold a reference
+ * on the users: an entry is removed once its user is disposed.
+ *
+ * Return value: the newly created registry
+ */
+GHashTable *
+twitter_user_registry_new (void)
+{
+  return g_hash_table_new (NULL, NULL);
+}
+
+void
+twitter_user_registry_destroy (GHashTable *registry)
+{
+  g_return_if_fail (registry != NULL);
+
+  g_hash_table_foreach (registry, registry_unref_user, registry);
+  g_hash_table_destroy (registry);
+}
+
+/*
+ * twitter_user_registry_intern:
+ * @registry: a user registry
+ * @user: a #TwitterUser
+ *
+ * Looks up the canonical instance for the id of @user inside
+ * @registry. If there is one, the contents of @user are merged
+ * into it; otherwise @user becomes the canonical instance.
+ *
+ * Return value: the canonical #TwitterUser; the returned object
+ *   is owned by its current holders and should be referenced
+ *   if needed
+ */
+TwitterUser *
+twitter_user_registry_intern (GHashTable  *registry,
+                              TwitterUser *user)
+{
+  TwitterUser *retval;
+  guint user_id;
+
+  g_return_val_if_fail (registry != NULL, user);
+  g_return_val_if_fail (TWITTER_IS_USER (user), NULL);
+
+  user_id = user->priv->id;
+  if (user_id == 0)
+    return user;
+
+  retval = g_hash_table_lookup (registry, GUINT_TO_POINTER (user_id));
+  if (retval == user)
+    return user;
+
+  if (retval)
+    {
+      twitter_user_merge (retval, user);
+      return retval;
+    }
+
+  g_hash_table_insert (registry, GUINT_TO_POINTER (user_id), user);
+  g_object_weak_ref (G_OBJECT (user), registry_weak_notify, registry);
+
+  return user;
+}
+
 G_CONST_RETURN gchar *
 twitter_user_get_name (TwitterUser *user)
 {
@@ -600,39 +915,151 @@ twitter_user_get_profile_image_url (TwitterUser *user)
   return user->priv->profile_image_url;
 }
 
+/* the size the profile images are scaled down to, or -1 */
+static gint profile_image_size = -1;
+
+/* the decoded profile images are kept in memory, shared by every
+ * TwitterUser with the same profile image URL, so that a user coming
+ * back does not need to load the image again; the images used least
+ * recently are dropped when they exceed profile_images_max_size
+ */
+#define DEFAULT_PROFILE_IMAGES_MAX_SIZE (4 * 1024 * 1024)
+
 typedef struct {
-  TwitterUser *user;
-  GFile *profile_image_file;
-  SoupSession *async_session;
-} GetProfileImageClosure;
+  gchar *url;
+  GdkPixbuf *pixbuf;
+  gsize size;
+} ProfileImage;
+
+/* url -> GList link inside profile_images_lru */
+static GHashTable *profile_images = NULL;
+
+/* most recently used first */
+static GQueue profile_images_lru = { NULL, NULL, 0 };
+
+static gsize profile_images_size = 0;
+static gsize profile_images_max_size = DEFAULT_PROFILE_IMAGES_MAX_SIZE;
+
+static guint profile_images_hits = 0;
+static guint profile_images_misses = 0;
 
 static void
-get_profile_image_vfs (GObject      *source_object,
-                       GAsyncResult *res,
-                       gpointer      data)
+profile_images_drop_last (void)
 {
-  GFile *file = G_FILE (source_object);
-  GetProfileImageClosure *closure = data;
-  TwitterUser *user = closure->user;
-  GError *error;
-  gchar *contents = NULL;
-  gsize len;
-  gchar *etags = NULL;
-  GdkPixbufLoader *loader;
+  ProfileImage *image = g_queue_pop_tail (&profile_images_lru);
 
-  error = NULL;
-  g_file_load_contents_finish (file, res, &contents, &len, &etags, &error);
-  if (error)
+  g_hash_table_remove (profile_images, image->url);
+  profile_images_size -= image->size;
+
+  g_object_unref (image->pixbuf);
+  g_free (image->url);
+  g_slice_free (ProfileImage, image);
+}
+
+static void
+profile_images_trim (void)
+{
+  while (profile_images_size > profile_images_max_size &&
+         !g_queue_is_empty (&profile_images_lru))
+    profile_images_drop_last ();
+}
+
+static GdkPixbuf *
+profile_images_lookup (const gchar *url)
+{
+  GList *link_;
+
+  link_ = profile_images ? g_hash_table_lookup (profile_images, url) : NULL;
+  if (!link_)
     {
-      g_warning ("Unable to retrieve the contents for `%s': %s",
-                 user->priv->profile_image_url,
-                 error->message);
-      g_error_free (error);
-      goto out;
+      profile_images_misses += 1;
+      return NULL;
     }
 
+  profile_images_hits += 1;
+
+  g_queue_unlink (&profile_images_lru, link_);
+  g_queue_push_head_link (&profile_images_lru, link_);
+
+  return ((ProfileImage *) link_->data)->pixbuf;
+}
+
+static void
+profile_images_insert (const gchar *url,
+                       GdkPixbuf   *pixbuf)
+{
+  ProfileImage *image;
+  GList *link_;
+
+  if (G_UNLIKELY (profile_images == NULL))
+    profile_images = g_hash_table_new (g_str_hash, g_str_equal);
+
+  link_ = g_hash_table_lookup (profile_images, url);
+  if (link_)
+    {
+      image = link_->data;
+
+      g_queue_unlink (&profile_images_lru, link_);
+      g_queue_push_head_link (&profile_images_lru, link_);
+
+      profile_images_size -= image->size;
+      g_object_unref (image->pixbuf);
+    }
+  else
+    {
+      image = g_slice_new (ProfileImage);
+      image->url = g_strdup (url);
+
+      g_queue_push_head (&profile_images_lru, image);
+      g_hash_table_insert (profile_images,
+                           image->url,
+                           profile_images_lru.head);
+    }
+
+  image->pixbuf = g_object_ref (pixbuf);
+  image->size = gdk_pixbuf_get_rowstride (pixbuf)
+              * gdk_pixbuf_get_height (pixbuf);
+
+  profile_images_size += image->size;
+
+  profile_images_trim ();
+}
+
+typedef struct {
+  TwitterUser *user;
+
+  gchar *url;
+  SoupBuffer *buffer;
+  gint size;
+
+  /* whether the data should be written to the cache */
+  guint store : 1;
+
+  /* the validators of the downloaded image */
+  gchar *etag;
+  gchar *last_modified;
+
+  GdkPixbuf *pixbuf;
+} DecodeJob;
+
+static GThreadPool *decode_pool = NULL;
+
+/* decodes the profile image and scales it down; this function does
+ * not touch the TwitterUser, since it might be called from a thread
+ */
+static void
+decode_job_run_sync (DecodeJob *job)
+{
+  GdkPixbufLoader *loader;
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+
   loader = gdk_pixbuf_loader_new ();
-  if (!gdk_pixbuf_loader_write (loader, (const guchar *) contents, len, &error))
+
+  if (!gdk_pixbuf_loader_write (loader,
+                                (const guchar *) job->buffer->data,
+                                job->buffer->length,
+                                &error))
     {
       if (error)
         {
@@ -641,10 +1068,7 @@ get_profile_image_vfs (GObject      *source_object,
         }
 
       g_object_unref (loader);
-      g_free (contents);
-      g_free (etags);
-
-      goto out;
+      return;
     }
 
   gdk_pixbuf_loader_close (loader, &error);
@@ -652,165 +1076,352 @@ get_profile_image_vfs (GObject      *source_object,
     {
       g_warning ("Unable to close the pixbuf loader: %s", error->message);
       g_error_free (error);
+      g_object_unref (loader);
+      return;
     }
-  else
+
+  pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+  if (pixbuf && job->size > 0)
     {
-#if 0
-      /* FIXME - remove with http support for GVFS */
-      gchar *user_sha1;
-      gchar *cache_dir;
-      gchar *cached_profile;
-
-      user_sha1 = g_compute_checksum_for_string (G_CHECKSUM_SHA1,
-                                                 user->priv->profile_image_url,
-                                                 -1);
-      cache_dir = g_build_filename (g_get_user_cache_dir (),
-                                    "twitter-glib",
-                                    "profile_images",
-                                    NULL);
-
-      if (g_mkdir_with_parents (cache_dir, 0700) == -1)
+      gint width = gdk_pixbuf_get_width (pixbuf);
+      gint height = gdk_pixbuf_get_height (pixbuf);
+
+      if (width > job->size || height > job->size)
         {
-          if (errno != EEXIST)
-            {
-              g_warning ("Unable to create the profile image cache: %s",
-                         g_strerror (errno));
-              g_object_unref (loader);
-              g_free (contents);
-              g_free (etags);
-              goto out;
-            }
+          gdouble scale = (gdouble) job->size / MAX (width, height);
+
+          job->pixbuf = gdk_pixbuf_scale_simple (pixbuf,
+                                                 MAX (1, width * scale),
+                                                 MAX (1, height * scale),
+                                                 GDK_INTERP_BILINEAR);
         }
+    }
 
-      cached_profile = g_build_filename (cache_dir, user_sha1, NULL);
-      g_file_set_contents (cached_profile, contents, len, NULL);
+  if (pixbuf && !job->pixbuf)
+    job->pixbuf = g_object_ref (pixbuf);
 
-      g_free (cached_profile);
-      g_free (cache_dir);
-      g_free (user_sha1);
-#endif
-    }
+  /* we cache the scaled down image, which is much smaller */
+  if (job->store && job->pixbuf)
+    {
+      gchar *data = NULL;
+      gsize length = 0;
 
-  user->priv->profile_image = gdk_pixbuf_loader_get_pixbuf (loader);
-  if (user->priv->profile_image)
-    g_object_ref (user->priv->profile_image);
+      if (job->pixbuf != pixbuf &&
+          gdk_pixbuf_save_to_buffer (job->pixbuf, &data, &length,
+                                     "png", NULL,
+                                     NULL))
+        {
+          twitter_image_cache_store (job->url,
+                                     job->etag, job->last_modified,
+                                     data, length);
+          g_free (data);
+        }
+      else
+        twitter_image_cache_store (job->url,
+                                   job->etag, job->last_modified,
+                                   job->buffer->data, job->buffer->length);
+    }
 
   g_object_unref (loader);
+}
 
-  g_free (contents);
-  g_free (etags);
+static gboolean
+decode_job_complete (gpointer data)
+{
+  DecodeJob *job = data;
+  TwitterUser *user = job->user;
 
-  g_signal_emit (user, user_signals[CHANGED], 0);
+  if (job->pixbuf && job->url)
+    profile_images_insert (job->url, job->pixbuf);
+
+  /* the profile image URL changed while decoding; the image of the
+   * new URL is loaded separately
+   */
+  if (g_strcmp0 (job->url, user->priv->profile_image_url) != 0)
+    {
+      if (job->pixbuf)
+        g_object_unref (job->pixbuf);
+
+      goto out;
+    }
+
+  /* another load of the same URL might have completed first */
+  if (job->pixbuf && user->priv->profile_image)
+    g_object_unref (job->pixbuf);
+  else if (job->pixbuf)
+    {
+      user->priv->profile_image = job->pixbuf;
+
+      g_signal_emit (user, user_signals[CHANGED], 0);
+    }
 
-out:
   user->priv->profile_image_load = FALSE;
+  twitter_user_clear_requesters (user);
 
-  g_object_unref (closure->profile_image_file);
-  g_object_unref (closure->user);
-  g_free (closure);
+out:
+  g_object_unref (user);
+
+  soup_buffer_free (job->buffer);
+  g_free (job->url);
+  g_free (job->etag);
+  g_free (job->last_modified);
+  g_free (job);
+
+  return FALSE;
 }
 
 static void
-get_profile_image_soup (SoupSession *session,
-                        SoupMessage *msg,
-                        gpointer     data)
+decode_job_run (gpointer data,
+                gpointer pool_data)
 {
-  GetProfileImageClosure *closure = data;
-  TwitterUser *user = closure->user;
-  GdkPixbufLoader *loader;
-  GError *error = NULL;
+  decode_job_run_sync (data);
+
+  /* the image must be set inside the main loop */
+  g_idle_add_full (G_PRIORITY_DEFAULT,
+                   decode_job_complete,
+                   data,
+                   NULL);
+}
+
+/*
+ * decode_profile_image:
+ * @user: a #TwitterUser; the function takes a reference on it
+ * @buffer: the contents of the image; the function takes ownership
+ *   of it
+ * @msg: the message used to download the image, if it should be
+ *   written to the cache, or %NULL
+ *
+ * Decodes the profile image of @user, using the decoding threads if
+ * possible; once the image has been decoded, the #TwitterUser::changed
+ * signal is emitted inside the main loop.
+ */
+static void
+decode_profile_image (TwitterUser *user,
+                      SoupBuffer  *buffer,
+                      SoupMessage *msg)
+{
+  DecodeJob *job;
+
+  job = g_new0 (DecodeJob, 1);
+  job->user = g_object_ref (user);
+  job->url = g_strdup (user->priv->profile_image_url);
+  job->buffer = buffer;
+  job->size = profile_image_size;
 
-  if (!SOUP_STATUS_IS_SUCCESSFUL (msg->status_code))
+  if (msg)
     {
-      g_warning ("Unable to retrieve the contents for `%s': %s",
-                 user->priv->profile_image_url,
-                 msg->reason_phrase);
-      goto out;
+      job->store = TRUE;
+      job->etag =
+        g_strdup (soup_message_headers_get (msg->response_headers, "ETag"));
+      job->last_modified =
+        g_strdup (soup_message_headers_get (msg->response_headers,
+                                            "Last-Modified"));
     }
 
-  loader = gdk_pixbuf_loader_new ();
-
-  if (!gdk_pixbuf_loader_write (loader,
-                                (const guchar *) msg->response_body->data,
-                                msg->response_body->length,
-                                &error))
+  if (g_thread_supported () && !decode_pool)
     {
+      GError *error = NULL;
+
+      decode_pool = g_thread_pool_new (decode_job_run, NULL,
+                                       2, FALSE,
+                                       &error);
       if (error)
         {
-          g_warning ("Unable to load the pixbuf: %s", error->message);
+          g_warning ("Unable to create the decoding threads: %s",
+                     error->message);
           g_error_free (error);
         }
+    }
 
-      g_object_unref (loader);
-      goto out;
+  if (!decode_pool)
+    {
+      decode_job_run_sync (job);
+      decode_job_complete (job);
+      return;
     }
 
-  gdk_pixbuf_loader_close (loader, &error);
-  if (error)
+  g_thread_pool_push (decode_pool, job, NULL);
+}
+
+typedef struct {
+  TwitterUser *user;
+  GFile *profile_image_file;
+
+  /* the profile image URL when the load started */
+  gchar *url;
+} GetProfileImageClosure;
+
+static void
+get_profile_image_vfs (GObject      *source_object,
+                       GAsyncResult *res,
+                       gpointer      data)
+{
+  GFile *file = G_FILE (source_object);
+  GetProfileImageClosure *closure = data;
+  TwitterUser *user = closure->user;
+  GError *error;
+  gchar *contents = NULL;
+  gsize len;
+
+  error = NULL;
+  g_file_load_contents_finish (file, res, &contents, &len, NULL, &error);
+
+  /* the profile image URL changed while loading */
+  if (g_strcmp0 (closure->url, user->priv->profile_image_url) != 0)
     {
-      g_warning ("Unable to close the pixbuf loader: %s", error->message);
+      if (error)
+        g_error_free (error);
+
+      g_free (contents);
+    }
+  else if (error)
+    {
+      g_warning ("Unable to retrieve the contents for `%s': %s",
+                 user->priv->profile_image_url,
+                 error->message);
       g_error_free (error);
-      g_object_unref (loader);
+
+      user->priv->profile_image_load = FALSE;
+      twitter_user_clear_requesters (user);
     }
   else
-    {
-      gchar *user_sha1;
-      gchar *cache_dir;
-      gchar *cached_profile;
+    decode_profile_image (user,
+                          soup_buffer_new (SOUP_MEMORY_TAKE, contents, len),
+                          NULL);
 
-      user_sha1 = g_compute_checksum_for_string (G_CHECKSUM_SHA1,
-                                                 user->priv->profile_image_url,
-                                                 -1);
-      cache_dir = g_build_filename (g_get_user_cache_dir (),
-                                    "twitter-glib",
-                                    "profile_images",
-                                    NULL);
+  g_object_unref (closure->profile_image_file);
+  g_object_unref (closure->user);
+  g_free (closure->url);
+  g_free (closure);
+}
 
-      if (g_mkdir_with_parents (cache_dir, 0700) == -1)
-        {
-          if (errno != EEXIST)
-            {
-              g_warning ("Unable to create the profile image cache: %s",
-                         g_strerror (errno));
-              g_object_unref (loader);
-              goto out;
-            }
-        }
+/* loads the profile image of @user from @cached_profile */
+static void
+load_cached_profile_image (TwitterUser *user,
+                           const gchar *cached_profile)
+{
+  GetProfileImageClosure *closure;
 
-      cached_profile = g_build_filename (cache_dir, user_sha1, NULL);
-      g_file_set_contents (cached_profile,
-                           msg->response_body->data,
-                           msg->response_body->length,
-                           NULL);
+  closure = g_new0 (GetProfileImageClosure, 1);
+  closure->user = g_object_ref (user);
+  closure->profile_image_file = g_file_new_for_path (cached_profile);
+  closure->url = g_strdup (user->priv->profile_image_url);
 
-      g_free (cached_profile);
-      g_free (cache_dir);
-      g_free (user_sha1);
+  g_file_load_contents_async (closure->profile_image_file,
+                              NULL,
+                              get_profile_image_vfs,
+                              closure);
+}
+
+static void
+get_profile_image_soup (SoupMessage *msg,
+                        gpointer     data)
+{
+  TwitterUser *user = data;
+  TwitterUserPrivate *priv = user->priv;
+  gchar *cached_profile;
+
+  priv->profile_image_fetch = NULL;
+
+  if (SOUP_STATUS_IS_SUCCESSFUL (msg->status_code))
+    {
+      decode_profile_image (user,
+                            soup_message_body_flatten (msg->response_body),
+                            msg);
+      goto out;
     }
 
-  user->priv->profile_image = gdk_pixbuf_loader_get_pixbuf (loader);
-  if (user->priv->profile_image)
-    g_object_ref (user->priv->profile_image);
+  /* our copy is still valid; we also fall back to it if the
+   * image could not be downloaded
+   */
+  if (msg->status_code == SOUP_STATUS_NOT_MODIFIED)
+    twitter_image_cache_revalidated (priv->profile_image_url);
 
-  g_object_unref (loader);
+  cached_profile = twitter_image_cache_lookup (priv->profile_image_url,
+                                               NULL,
+                                               NULL, NULL);
+  if (cached_profile)
+    {
+      load_cached_profile_image (user, cached_profile);
+      g_free (cached_profile);
+    }
+  else
+    {
+      g_warning ("Unable to retrieve the contents for `%s': %s",
+                 priv->profile_image_url,
+                 msg->reason_phrase);
 
-  g_signal_emit (user, user_signals[CHANGED], 0);
+      priv->profile_image_load = FALSE;
+      twitter_user_clear_requesters (user);
+    }
 
 out:
-  user->priv->profile_image_load = FALSE;
+  g_object_unref (user);
+}
 
-  g_object_unref (closure->user);
-  g_free (closure);
+static void
+twitter_user_remove_requester (TwitterUser *user,
+                               GObject     *requester)
+{
+  TwitterUserPrivate *priv = user->priv;
+
+  priv->profile_image_requesters =
+    g_slist_remove (priv->profile_image_requesters, requester);
+
+  if (priv->profile_image_requesters || priv->profile_image_pinned)
+    return;
+
+  /* nobody is waiting for the image anymore: if we are still
+   * downloading it, give the connection to someone else
+   */
+  if (priv->profile_image_fetch)
+    {
+      twitter_image_fetcher_cancel (priv->profile_image_fetch);
+      priv->profile_image_fetch = NULL;
+      priv->profile_image_load = FALSE;
+
+      g_object_unref (user);
+    }
 }
 
+static void
+requester_weak_notify (gpointer  data,
+                       GObject  *where_the_object_was)
+{
+  twitter_user_remove_requester (data, where_the_object_was);
+}
+
+/**
+ * twitter_user_request_profile_image:
+ * @user: a #TwitterUser
+ * @requester: the object that needs the profile image, or %NULL
+ * @urgent: %TRUE if the image should be fetched before the non
+ *   urgent ones, e.g. because it is currently visible
+ *
+ * Retrieves the profile image of @user. If the image has not been
+ * loaded yet, this function starts loading it and returns %NULL;
+ * the #TwitterUser::changed signal will be emitted once the image
+ * is available.
+ *
+ * All the profile images are downloaded using a shared queue; if
+ * @requester is not %NULL, the download is cancelled when every
+ * object that requested the image has been destroyed.
+ *
+ * Return value: a #GdkPixbuf or %NULL. The returned pixbuf is owned
+ *   by the #TwitterUser and should not be unreferenced
+ */
 GdkPixbuf *
-twitter_user_get_profile_image (TwitterUser *user)
+twitter_user_request_profile_image (TwitterUser *user,
+                                    GObject     *requester,
+                                    gboolean     urgent)
 {
   TwitterUserPrivate *priv;
-  GetProfileImageClosure *closure;
-  gchar *user_sha1, *cached_profile;
+  gchar *cached_profile;
+  gchar *etag, *last_modified;
+  gboolean is_stale;
 
   g_return_val_if_fail (TWITTER_IS_USER (user), NULL);
+  g_return_val_if_fail (requester == NULL || G_IS_OBJECT (requester), NULL);
 
   priv = user->priv;
 
@@ -820,58 +1431,206 @@ twitter_user_get_profile_image (TwitterUser *user)
   if (priv->profile_image)
     return priv->profile_image;
 
-  if (priv->profile_image_load)
-    return NULL;
-
-  priv->profile_image_load = TRUE;
+  /* another user might have loaded the same image already */
+  if (!priv->profile_image_load)
+    {
+      GdkPixbuf *pixbuf = profile_images_lookup (priv->profile_image_url);
 
-  user_sha1 = g_compute_checksum_for_string (G_CHECKSUM_SHA1,
-                                             priv->profile_image_url,
-                                             -1);
-  cached_profile = g_build_filename (g_get_user_cache_dir (),
-                                     "twitter-glib",
-                                     "profile_images",
-                                     user_sha1,
-                                     NULL);
+      if (pixbuf)
+        {
+          priv->profile_image = g_object_ref (pixbuf);
+          return priv->profile_image;
+        }
+    }
 
-  closure = g_new0 (GetProfileImageClosure, 1);
-  closure->user = g_object_ref (user);
+  if (!requester)
+    priv->profile_image_pinned = TRUE;
+  else if (!g_slist_find (priv->profile_image_requesters, requester))
+    {
+      g_object_weak_ref (requester, requester_weak_notify, user);
+      priv->profile_image_requesters =
+        g_slist_prepend (priv->profile_image_requesters, requester);
+    }
 
-  if (g_file_test (cached_profile, G_FILE_TEST_EXISTS))
+  if (priv->profile_image_load)
     {
-      gchar *profile_image_uri;
+      if (urgent && priv->profile_image_fetch)
+        twitter_image_fetcher_promote (priv->profile_image_fetch);
 
-      profile_image_uri = g_filename_to_uri (cached_profile, NULL, NULL);
+      return NULL;
+    }
 
-      closure->profile_image_file = g_file_new_for_uri (profile_image_uri);
+  priv->profile_image_load = TRUE;
 
-      g_file_load_contents_async (closure->profile_image_file,
-                                  NULL,
-                                  get_profile_image_vfs,
-                                  closure);
+  etag = last_modified = NULL;
+  is_stale = FALSE;
 
-      g_free (profile_image_uri);
-    }
+  cached_profile = twitter_image_cache_lookup (priv->profile_image_url,
+                                               &is_stale,
+                                               &etag, &last_modified);
+
+  if (cached_profile && !is_stale)
+    load_cached_profile_image (user, cached_profile);
   else
     {
-      SoupMessage *msg;
-
-      if (!priv->async_session)
-        priv->async_session = soup_session_async_new ();
+      /* a stale copy is downloaded again only if it changed */
+      priv->profile_image_fetch =
+        twitter_image_fetcher_queue (priv->profile_image_url,
+                                     etag, last_modified,
+                                     urgent,
+                                     get_profile_image_soup,
+                                     g_object_ref (user));
+
+      if (!priv->profile_image_fetch)
+        {
+          g_warning ("Invalid profile image URL `%s'",
+                     priv->profile_image_url);
 
-      msg = soup_message_new (SOUP_METHOD_GET, priv->profile_image_url);
+          priv->profile_image_load = FALSE;
+          twitter_user_clear_requesters (user);
 
-      soup_session_queue_message (priv->async_session, msg,
-                                  get_profile_image_soup,
-                                  closure);
+          g_object_unref (user);
+        }
     }
 
-  g_free (user_sha1);
   g_free (cached_profile);
+  g_free (etag);
+  g_free (last_modified);
 
   return NULL;
 }
 
+/**
+ * twitter_user_release_profile_image:
+ * @user: a #TwitterUser
+ * @requester: the object that requested the profile image
+ *
+ * Tells @user that @requester does not need the profile image
+ * anymore, e.g. because it is going to be reused for another
+ * user. If nobody else requested the image, the download is
+ * cancelled as if @requester had been destroyed.
+ */
+void
+twitter_user_release_profile_image (TwitterUser *user,
+                                    GObject     *requester)
+{
+  TwitterUserPrivate *priv;
+
+  g_return_if_fail (TWITTER_IS_USER (user));
+  g_return_if_fail (G_IS_OBJECT (requester));
+
+  priv = user->priv;
+
+  if (!g_slist_find (priv->profile_image_requesters, requester))
+    return;
+
+  g_object_weak_unref (requester, requester_weak_notify, user);
+  twitter_user_remove_requester (user, requester);
+}
+
+/**
+ * twitter_user_get_profile_image:
+ * @user: a #TwitterUser
+ *
+ * Retrieves the profile image of @user; see
+ * twitter_user_request_profile_image() for details.
+ *
+ * Return value: a #GdkPixbuf or %NULL
+ */
+GdkPixbuf *
+twitter_user_get_profile_image (TwitterUser *user)
+{
+  return twitter_user_request_profile_image (user, NULL, TRUE);
+}
+
+/**
+ * twitter_user_set_profile_image_size:
+ * @size: the largest size a profile image is displayed at, or -1
+ *
+ * Sets the size the profile images are scaled down to when they are
+ * decoded, so that the full size images are not kept around; the
+ * aspect ratio of the images is preserved. Only the images loaded
+ * after calling this function are affected.
+ */
+void
+twitter_user_set_profile_image_size (gint size)
+{
+  g_return_if_fail (size > 0 || size == -1);
+
+  profile_image_size = size;
+}
+
+/**
+ * twitter_user_set_profile_image_cache_size:
+ * @max_size: the maximum size of the cache, in bytes
+ *
+ * Sets the maximum size of the on-disk cache shared by every
+ * #TwitterUser for the profile images; when the cache grows
+ * bigger than that, the least recently used images are removed.
+ */
+void
+twitter_user_set_profile_image_cache_size (gsize max_size)
+{
+  twitter_image_cache_set_max_size (max_size);
+}
+
+/**
+ * twitter_user_set_profile_image_memory_size:
+ * @max_size: the maximum size of the decoded profile images kept
+ *   in memory, in bytes
+ *
+ * Sets the maximum size of the decoded profile images shared by
+ * every #TwitterUser; when they exceed it, the least recently used
+ * images are dropped. A #TwitterUser keeps its own image even if
+ * it is dropped from the shared images.
+ */
+void
+twitter_user_set_profile_image_memory_size (gsize max_size)
+{
+  profile_images_max_size = max_size;
+
+  profile_images_trim ();
+}
+
+/**
+ * twitter_user_get_profile_image_stats:
+ * @hits: return location for the number of profile images found
+ *   in memory, or %NULL
+ * @misses: return location for the number of profile images that
+ *   had to be loaded, or %NULL
+ *
+ * Retrieves how many times a profile image requested by a
+ * #TwitterUser was already loaded by another #TwitterUser.
+ */
+void
+twitter_user_get_profile_image_stats (guint *hits,
+                                      guint *misses)
+{
+  if (hits)
+    *hits = profile_images_hits;
+
+  if (misses)
+    *misses = profile_images_misses;
+}
+
+/**
+ * twitter_user_set_profile_image_queue:
+ * @max_conns_per_host: the maximum number of concurrent downloads
+ *   from the same host
+ * @policy: the order in which the downloads are started
+ *
+ * Sets the limits of the queue shared by every #TwitterUser when
+ * downloading the profile images.
+ */
+void
+twitter_user_set_profile_image_queue (guint              max_conns_per_host,
+                                      TwitterQueuePolicy policy)
+{
+  g_return_if_fail (max_conns_per_host > 0);
+
+  twitter_image_fetcher_set_limits (max_conns_per_host, policy);
+}
+
 guint
 twitter_user_get_id (TwitterUser *user)
 {
@@ -34,6 +34,9 @@ TwitterUser *         twitter_user_new_from_data         (const gchar *buffer);
 
 void                  twitter_user_load_from_data        (TwitterUser *user,
                                                           const gchar *buffer);
+void                  twitter_user_load_from_buffer      (TwitterUser *user,
+                                                          const gchar *buffer,
+                                                          gssize       length);
 
 G_CONST_RETURN gchar *twitter_user_get_name              (TwitterUser *user);
 G_CONST_RETURN gchar *twitter_user_get_url               (TwitterUser *user);
@@ -56,6 +59,19 @@ G_CONST_RETURN gchar *twitter_user_get_time_zone         (TwitterUser *user);
 gint                  twitter_user_get_utc_offset        (TwitterUser *user);
 
 GdkPixbuf *           twitter_user_get_profile_image     (TwitterUser *user);
+GdkPixbuf *           twitter_user_request_profile_image (TwitterUser *user,
+                                                          GObject     *requester,
+                                                          gboolean     urgent);
+void                  twitter_user_release_profile_image (TwitterUser *user,
+                                                          GObject     *requester);
+
+void                  twitter_user_set_profile_image_size        (gint               size);
+void                  twitter_user_set_profile_image_cache_size  (gsize              max_size);
+void                  twitter_user_set_profile_image_memory_size (gsize              max_size);
+void                  twitter_user_get_profile_image_stats       (guint             *hits,
+                                                                  guint             *misses);
+void                  twitter_user_set_profile_image_queue       (guint              max_conns_per_host,
+                                                                  TwitterQueuePolicy policy);
 
 G_END_DECLS
 